@@ -0,0 +1,111 @@
+//
+// Compares BoundaryIndex::bounded_side with Polygon_2::bounded_side on random
+// star-shaped polygons. Queries mix random points with polygon vertices and
+// edge midpoints, so the boundary cases are exercised too.
+//
+// Usage: boundary_index_benchmark [queries]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "BoundaryIndex.h"
+#include "cgal_definitions.h"
+
+using namespace std;
+
+static Polygon_2 randomStarPolygon(int n, std::mt19937& gen) {
+    std::uniform_real_distribution<double> angle(0, 2 * M_PI);
+    std::uniform_int_distribution<int> radius(200, 1000);
+
+    vector<double> angles;
+
+    for (int i = 0; i < n; i++) {
+        angles.push_back(angle(gen));
+    }
+
+    std::sort(angles.begin(), angles.end());
+
+    Polygon_2 polygon;
+
+    for (double a : angles) {
+        polygon.push_back(Point(std::round(1000 + radius(gen) * std::cos(a)), std::round(1000 + radius(gen) * std::sin(a))));
+    }
+
+    return polygon;
+}
+
+int main(int argc, char** argv) {
+    int queries = (argc > 1) ? atoi(argv[1]) : 100000;
+
+    std::mt19937 gen(42);
+
+    cout << "vertices, queries, bounded_side ms, index build ms, index ms, speedup, fallbacks, mismatches" << endl;
+
+    for (int n : {16, 128, 1024, 8192}) {
+        Polygon_2 polygon = randomStarPolygon(n, gen);
+
+        std::uniform_int_distribution<int> coordinate(-10, 2010);
+
+        vector<Point> points;
+
+        for (int q = 0; q < queries; q++) {
+            if (q % 7 == 0) {
+                points.push_back(polygon[q % n]);
+            } else if (q % 11 == 0) {
+                const Point& a = polygon[q % n];
+                const Point& b = polygon[(q + 1) % n];
+
+                points.push_back(Point((a.x() + b.x()) / 2, (a.y() + b.y()) / 2));
+            } else {
+                points.push_back(Point(coordinate(gen), coordinate(gen)));
+            }
+        }
+
+        vector<CGAL::Bounded_side> expected, actual;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (const Point& p : points) {
+            expected.push_back(polygon.bounded_side(p));
+        }
+
+        auto built = std::chrono::steady_clock::now();
+
+        BoundaryIndex index(polygon);
+
+        auto indexed = std::chrono::steady_clock::now();
+
+        for (const Point& p : points) {
+            actual.push_back(index.bounded_side(p));
+        }
+
+        auto end = std::chrono::steady_clock::now();
+
+        int mismatches = 0;
+
+        for (size_t i = 0; i < points.size(); i++) {
+            if (expected[i] != actual[i]) {
+                mismatches++;
+            }
+        }
+
+        double scan_ms = std::chrono::duration<double, std::milli>(built - start).count();
+        double build_ms = std::chrono::duration<double, std::milli>(indexed - built).count();
+        double index_ms = std::chrono::duration<double, std::milli>(end - indexed).count();
+
+        cout << n << ", " << queries << ", " << scan_ms << ", " << build_ms << ", " << index_ms << ", " << scan_ms / index_ms << ", " << index.fallback_queries() << ", " << mismatches << endl;
+
+        if (mismatches > 0) {
+            cerr << "BoundaryIndex disagrees with bounded_side" << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
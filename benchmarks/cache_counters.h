@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//
+// Hardware cache-miss counter for the calling thread, read through Linux
+// perf_event_open. Where no counter can be opened (other systems, or
+// containers and kernels that deny perf access) available() is false and
+// stop() returns -1, so benchmarks still run and print timings.
+//
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#if defined(__linux__)
+        struct perf_event_attr attr;
+
+        std::memset(&attr, 0, sizeof(attr));
+
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~CacheMissCounter() {
+#if defined(__linux__)
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    bool available() const {
+        return fd >= 0;
+    }
+
+    void start() {
+#if defined(__linux__)
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // Misses since start, or -1 without a counter
+    long long stop() {
+#if defined(__linux__)
+        if (fd >= 0) {
+            std::uint64_t count = 0;
+
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+            if (read(fd, &count, sizeof(count)) == (ssize_t)sizeof(count)) {
+                return (long long)count;
+            }
+        }
+#endif
+        return -1;
+    }
+
+private:
+    int fd = -1;
+};
@@ -0,0 +1,148 @@
+//
+// Effect of utils::spatial_order on face traversals. A triangulation of
+// random points is visited in container order and in Hilbert order: the scan
+// classifies every face and walks to its centroid from the face visited
+// before (as consecutive trial insertions do), the insert pass splits every
+// face at its centroid in a copy. Cache misses are read from the hardware
+// counters where perf_event_open is permitted, -1 otherwise.
+//
+// Usage: face_order_benchmark [repeats]
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "cache_counters.h"
+#include "cgal_definitions.h"
+#include "utils.hpp"
+
+using namespace std;
+
+struct Pass {
+    double ms = 0;
+    long long misses = 0;
+};
+
+static Point centroid(CDT::Face_handle face) {
+    return CGAL::centroid(face->vertex(0)->point(), face->vertex(1)->point(), face->vertex(2)->point());
+}
+
+// Classifies every face and locates its centroid from the previous face
+static Pass scan(CDT& cdt, const vector<CDT::Face_handle>& faces, const vector<Point>& centroids, int& obtuse) {
+    CacheMissCounter counter;
+    CDT::Face_handle previous;
+
+    auto start = std::chrono::steady_clock::now();
+
+    counter.start();
+
+    for (size_t i = 0; i < faces.size(); i++) {
+        Point a = faces[i]->vertex(0)->point(), b = faces[i]->vertex(1)->point(), c = faces[i]->vertex(2)->point();
+
+        if (utils::is_obtuse(a, b, c)) {
+            obtuse++;
+        }
+
+        previous = cdt.locate(centroids[i], previous == CDT::Face_handle() ? faces[i] : previous);
+    }
+
+    Pass pass;
+
+    pass.misses = counter.stop();
+    pass.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return pass;
+}
+
+// Splits every face at its centroid; without flips the other faces stay valid
+static Pass split(CDT& cdt, const vector<CDT::Face_handle>& faces, const vector<Point>& centroids) {
+    CacheMissCounter counter;
+
+    auto start = std::chrono::steady_clock::now();
+
+    counter.start();
+
+    for (size_t i = 0; i < faces.size(); i++) {
+        cdt.insertByStrategy(centroids[i], 1, faces[i]);
+    }
+
+    Pass pass;
+
+    pass.misses = counter.stop();
+    pass.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return pass;
+}
+
+int main(int argc, char** argv) {
+    int repeats = (argc > 1) ? atoi(argv[1]) : 3;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> coordinate(0, 100000);
+
+    if (!CacheMissCounter().available()) {
+        cerr << "No hardware cache counters (perf_event_open denied); misses are reported as -1" << endl;
+    }
+
+    cout << "vertices, faces, order, sort ms, scan ms, scan misses, insert ms, insert misses" << endl;
+
+    for (int n : {8192, 65536, 262144}) {
+        vector<Point> points;
+
+        for (int i = 0; i < n; i++) {
+            points.push_back(Point(coordinate(gen), coordinate(gen)));
+        }
+
+        CDT cdt;
+
+        for (const Point& p : points) { // one at a time, so faces are laid out in creation order
+            cdt.insert(p);
+        }
+
+        for (int ordered = 0; ordered < 2; ordered++) {
+            Pass scanned, inserted;
+            double sort_ms = 0;
+            int obtuse = 0;
+
+            for (int r = 0; r < repeats; r++) {
+                CDT copy(cdt);
+
+                vector<CDT::Face_handle> faces;
+
+                for (auto fit = copy.finite_faces_begin(); fit != copy.finite_faces_end(); ++fit) {
+                    faces.push_back(fit);
+                }
+
+                auto start = std::chrono::steady_clock::now();
+
+                if (ordered) {
+                    utils::spatial_order(faces);
+                }
+
+                sort_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                vector<Point> centroids;
+
+                for (CDT::Face_handle face : faces) {
+                    centroids.push_back(centroid(face));
+                }
+
+                Pass s = scan(copy, faces, centroids, obtuse);
+                Pass i = split(copy, faces, centroids);
+
+                scanned.ms += s.ms;
+                scanned.misses = (s.misses < 0) ? -1 : scanned.misses + s.misses;
+                inserted.ms += i.ms;
+                inserted.misses = (i.misses < 0) ? -1 : inserted.misses + i.misses;
+            }
+
+            cout << n << ", " << cdt.number_of_faces() << ", " << (ordered ? "hilbert" : "container") << ", " << sort_ms / repeats << ", " << scanned.ms / repeats << ", "
+                 << (scanned.misses < 0 ? -1 : scanned.misses / repeats) << ", " << inserted.ms / repeats << ", " << (inserted.misses < 0 ? -1 : inserted.misses / repeats) << endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+//
+// Scaling of point location with and without the jump-and-walk grid of
+// CustomConstrainedDelaunayTriangulation_2. For triangulations of growing
+// size it times unhinted locate() calls on random points, then the insertion
+// of random Steiner points with insertByStrategy (which locates them the same
+// way). Both modes must find the same faces and end with the same vertices.
+//
+// Usage: locate_benchmark [queries]
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "cgal_definitions.h"
+
+using namespace std;
+
+static vector<Point> randomPoints(int n, std::mt19937& gen) {
+    std::uniform_real_distribution<double> coordinate(0, 100000);
+
+    vector<Point> points;
+
+    for (int i = 0; i < n; i++) {
+        points.push_back(Point(coordinate(gen), coordinate(gen)));
+    }
+
+    return points;
+}
+
+// Milliseconds spent locating every query in cdt; the faces found go to faces
+static double timeLocate(CDT& cdt, const vector<Point>& queries, vector<CDT::Face_handle>& faces) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (const Point& p : queries) {
+        faces.push_back(cdt.locate(p));
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Milliseconds spent inserting every point into cdt without flips
+static double timeInsert(CDT& cdt, const vector<Point>& points) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (const Point& p : points) {
+        cdt.insertByStrategy(p, 1); // any strategy above 0 skips the flips
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+    int queries = (argc > 1) ? atoi(argv[1]) : 100000;
+
+    std::mt19937 gen(42);
+
+    cout << "vertices, queries, walk ms, grid ms, speedup, walk insert ms, grid insert ms, insert speedup, mismatches" << endl;
+
+    for (int n : {1024, 8192, 65536, 262144}) {
+        vector<Point> points = randomPoints(n, gen);
+        vector<Point> targets = randomPoints(queries, gen);
+
+        CDT walk;
+
+        walk.insert(points.begin(), points.end());
+        walk.use_locate_grid = false;
+
+        CDT grid(walk);
+
+        grid.use_locate_grid = true;
+
+        vector<CDT::Face_handle> walk_faces, grid_faces;
+
+        double walk_ms = timeLocate(walk, targets, walk_faces);
+        double grid_ms = timeLocate(grid, targets, grid_faces); // includes building the grid
+
+        int mismatches = 0;
+
+        for (size_t i = 0; i < targets.size(); i++) { // the copies share vertex order, so compare by corner points
+            bool same = (walk.is_infinite(walk_faces[i]) && grid.is_infinite(grid_faces[i]));
+
+            for (int k = 0; !same && k < 3; k++) {
+                same = true;
+
+                for (int j = 0; j < 3; j++) {
+                    if (walk_faces[i]->vertex(j)->point() != grid_faces[i]->vertex((j + k) % 3)->point()) {
+                        same = false;
+                        break;
+                    }
+                }
+            }
+
+            if (!same) {
+                mismatches++;
+            }
+        }
+
+        double walk_insert_ms = timeInsert(walk, targets);
+        double grid_insert_ms = timeInsert(grid, targets);
+
+        if (walk.number_of_vertices() != grid.number_of_vertices() || !grid.is_valid()) {
+            mismatches++;
+        }
+
+        cout << n << ", " << queries << ", " << walk_ms << ", " << grid_ms << ", " << walk_ms / grid_ms << ", " << walk_insert_ms << ", " << grid_insert_ms << ", " << walk_insert_ms / grid_insert_ms << ", " << mismatches << endl;
+
+        if (mismatches > 0) {
+            cerr << "Grid-started point location disagrees with the plain walk" << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+//
+// Utilization of TaskScheduler against a simple thread pool that splits each
+// round of tasks into one contiguous block per thread (the split of
+// parallel_scan). A round mimics the trials of one face: mostly cheap tasks,
+// with the expensive ones (POLYGON-like) clustered together, so a static
+// split leaves most threads idle while one works through the cluster. Both
+// run the same rounds with the same number of workers, the calling thread
+// included.
+//
+// Usage: scheduler_benchmark [threads] [tasks]
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "TaskScheduler.h"
+
+using namespace std;
+
+static const int ROUNDS = 200;
+static const int EXPENSIVE_FACTOR = 50; // cost of an expensive task, in cheap ones
+static const int EXPENSIVE_EVERY = 16;  // one task in so many is expensive
+
+static std::atomic<unsigned long long> sink{0};
+
+// Spins for cost units of work, returns the nanoseconds spent
+static unsigned long long work(int cost) {
+    auto start = std::chrono::steady_clock::now();
+
+    unsigned long long x = cost;
+
+    for (int i = 0; i < cost * 20000; i++) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+
+    sink += x;
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Costs of the tasks of every round, expensive tasks next to each other
+static vector<vector<int>> rounds(int tasks, std::mt19937& gen) {
+    vector<vector<int>> costs;
+
+    int expensive = std::max(1, tasks / EXPENSIVE_EVERY);
+
+    for (int r = 0; r < ROUNDS; r++) {
+        vector<int> round(tasks, 1);
+
+        int first = gen() % (tasks - expensive + 1);
+
+        for (int i = first; i < first + expensive; i++) {
+            round[i] = EXPENSIVE_FACTOR;
+        }
+
+        costs.push_back(round);
+    }
+
+    return costs;
+}
+
+struct Outcome {
+    double ms = 0;
+    double utilization = 0;
+};
+
+static Outcome staticPool(const vector<vector<int>>& costs, unsigned int threads) {
+    std::atomic<unsigned long long> busy{0};
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (const vector<int>& round : costs) {
+        size_t chunk = (round.size() + threads - 1) / threads;
+
+        auto block = [&](unsigned int t) {
+            for (size_t i = t * chunk; i < std::min(round.size(), (t + 1) * chunk); i++) {
+                busy += work(round[i]);
+            }
+        };
+
+        vector<std::thread> pool;
+
+        for (unsigned int t = 1; t < threads; t++) {
+            pool.emplace_back(block, t);
+        }
+
+        block(0);
+
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return Outcome{1000 * seconds, busy / (seconds * 1e9 * threads)};
+}
+
+static Outcome stealing(const vector<vector<int>>& costs, unsigned int threads) {
+    TaskScheduler scheduler(threads - 1);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (const vector<int>& round : costs) {
+        TaskScheduler::Group group;
+
+        for (int cost : round) {
+            scheduler.submit(group, [cost](unsigned int) { work(cost); });
+        }
+
+        scheduler.wait(group);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return Outcome{1000 * seconds, scheduler.utilization()};
+}
+
+int main(int argc, char** argv) {
+    unsigned int threads = (argc > 1) ? atoi(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    int tasks = (argc > 2) ? atoi(argv[2]) : 64;
+
+    std::mt19937 gen(42);
+
+    vector<vector<int>> costs = rounds(tasks, gen);
+
+    cout << "scheduler, threads, tasks per round, rounds, ms, utilization" << endl;
+
+    Outcome pool = staticPool(costs, threads);
+
+    cout << "static split, " << threads << ", " << tasks << ", " << ROUNDS << ", " << pool.ms << ", " << pool.utilization << endl;
+
+    Outcome scheduler = stealing(costs, threads);
+
+    cout << "work stealing, " << threads << ", " << tasks << ", " << ROUNDS << ", " << scheduler.ms << ", " << scheduler.utilization << endl;
+
+    return 0;
+}
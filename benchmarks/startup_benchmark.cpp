@@ -0,0 +1,147 @@
+//
+// Times the construction of the initial triangulation of instances: the
+// incremental build (one point or constraint at a time, each located from an
+// arbitrary face) against utils::buildTriangulation. Both must produce the
+// same number of vertices, faces and constrained edges, and every vertex of
+// the bulk build must carry the input index of its point (the export numbers
+// input vertices by it).
+//
+// Usage: startup_benchmark [repeats] instance.json...
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "JsonLoader.h"
+#include "cgal_definitions.h"
+#include "utils.hpp"
+
+using namespace std;
+
+static void buildIncrementally(CDT& cdt, const vector<Point>& points, const vector<std::pair<int, int>>& constraints, const vector<int>& boundary) {
+    for (const Point& p : points) {
+        cdt.insert(p);
+    }
+
+    for (const auto& constraint : constraints) {
+        cdt.insert_constraint(points[constraint.first], points[constraint.second]);
+    }
+
+    for (size_t i = 0; i < boundary.size(); i++) {
+        cdt.insert_constraint(points[boundary[i]], points[boundary[(i + 1) % boundary.size()]]);
+    }
+}
+
+// Vertices whose VertexInfo::input does not name their point, plus input points without a vertex
+static size_t inputMismatches(CDT& cdt, const vector<Point>& points) {
+    vector<bool> seen(points.size(), false);
+    size_t n = 0;
+
+    for (auto vit = cdt.finite_vertices_begin(); vit != cdt.finite_vertices_end(); ++vit) {
+        int input = vit->info().input;
+
+        if (input < 0 || input >= (int)points.size() || points[input] != vit->point()) {
+            n++;
+            continue;
+        }
+
+        seen[input] = true;
+    }
+
+    for (size_t i = 0; i < points.size(); i++) {
+        if (!seen[i]) { // a duplicate point shares the vertex of its first copy
+            bool duplicate = false;
+
+            for (size_t j = 0; j < i && !duplicate; j++) {
+                duplicate = seen[j] && points[j] == points[i];
+            }
+
+            if (!duplicate) {
+                n++;
+            }
+        }
+    }
+
+    return n;
+}
+
+static size_t constrainedEdges(CDT& cdt) {
+    size_t n = 0;
+
+    for (auto edge = cdt.finite_edges_begin(); edge != cdt.finite_edges_end(); ++edge) {
+        if (cdt.is_constrained(*edge)) {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+int main(int argc, char** argv) {
+    // repeats is optional: the first argument counts only when it is a number
+    int first = 1;
+    int repeats = 3;
+
+    if (argc > 1 && argv[1][0] != '\0' && strspn(argv[1], "0123456789") == strlen(argv[1])) {
+        repeats = std::max(1, atoi(argv[1]));
+        first = 2;
+    }
+
+    if (argc <= first) {
+        cout << "Usage: startup_benchmark [repeats] instance.json..." << endl;
+        return 0;
+    }
+
+    cout << "instance, points, constraints, incremental ms, bulk ms, speedup, mismatches" << endl;
+
+    for (int i = first; i < argc; i++) {
+        JsonLoader loader;
+
+        loader.load(argv[i], false);
+
+        vector<Point> points = loader.getPoints();
+        vector<std::pair<int, int>> constraints = loader.getConstraints();
+        vector<int> boundary = loader.getRegionBoundaries();
+
+        double incremental_ms = 0, bulk_ms = 0;
+        int mismatches = 0;
+
+        for (int r = 0; r < repeats; r++) {
+            CDT incremental, bulk;
+
+            auto start = std::chrono::steady_clock::now();
+
+            buildIncrementally(incremental, points, constraints, boundary);
+
+            auto middle = std::chrono::steady_clock::now();
+
+            utils::buildTriangulation(bulk, points, constraints, boundary);
+
+            auto end = std::chrono::steady_clock::now();
+
+            incremental_ms += std::chrono::duration<double, std::milli>(middle - start).count();
+            bulk_ms += std::chrono::duration<double, std::milli>(end - middle).count();
+
+            if (incremental.number_of_vertices() != bulk.number_of_vertices() || incremental.number_of_faces() != bulk.number_of_faces() || constrainedEdges(incremental) != constrainedEdges(bulk) || inputMismatches(bulk, points) > 0) {
+                mismatches++;
+            }
+        }
+
+        incremental_ms /= repeats;
+        bulk_ms /= repeats;
+
+        cout << loader.getInstance() << ", " << points.size() << ", " << constraints.size() + boundary.size() << ", " << incremental_ms << ", " << bulk_ms << ", " << incremental_ms / bulk_ms << ", " << mismatches << endl;
+
+        if (mismatches > 0) {
+            cerr << "The bulk build differs from the incremental one" << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <gmp.h>
 #include <iostream>
 #include <map>
@@ -19,10 +20,15 @@
 
 // Support classes
 #include "AntColonyStructures.h"
+#include "ExactCollapse.h"
 #include "JsonExporter.h"
 #include "JsonLoader.h"
 #include "RandomizationMethod.h"
 #include "graph_definitions.h"
+#include "parallel_scan.h"
+#include "search_traits.h"
+#include "TaskScheduler.h"
+#include "TrialEvaluation.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
 
@@ -36,39 +42,6 @@ private:
         return alpha * obtuse_triangles + beta * steiner_points;
     }
 
-    float radius_to_height_ratio(const Point& p1, const Point& p2, const Point& p3) {
-        // Calculate side lengths of the triangle
-        float a = std::sqrt(CGAL::to_double(CGAL::squared_distance(p2, p3)));
-        float b = std::sqrt(CGAL::to_double(CGAL::squared_distance(p1, p3)));
-        float c = std::sqrt(CGAL::to_double(CGAL::squared_distance(p1, p2)));
-
-        // Calculate the semi-perimeter of the triangle
-        float s = (a + b + c) / 2.0f;
-
-        // Calculate the area of the triangle using Heron's formula
-        float area = std::sqrt(s * (s - a) * (s - b) * (s - c));
-
-        // Check if the area is zero to prevent division by zero
-        if (area == 0) {
-            std::cerr << "Degenerate triangle detected!" << std::endl;
-            return -1.0f; // Indicate an error
-        }
-
-        // Calculate the circumradius R
-        float R = (a * b * c) / (4.0f * area);
-
-        // Find the longest side
-        float longest_side = std::max({a, b, c});
-
-        // Calculate the height corresponding to the longest side
-        float height = (2.0f * area) / longest_side;
-
-        // Calculate the radius-to-height ratio
-        float rho = R / height;
-
-        return rho;
-    }
-
     float heuristic_function_vertex_projection(float p) {
         if (p <= 1.0) {
             return 0.0f;
@@ -163,16 +136,16 @@ private:
         return updated_pheromone;
     }
 
-    int countObtuseNeighbors(Graph& graph, Point& a, Point& b, Point& c) {
+    int countObtuseNeighbors(Graph& graph, CDT::Face_handle face) {
         int counter = 0;
 
         for (int vertex_index = 0; vertex_index < 3; vertex_index++) {
             int neighbor_vertex_index = 0;
 
-            Face* face = utils::findNeighbor(graph, a, b, c, vertex_index, neighbor_vertex_index);
+            Face* neighbor = utils::findNeighbor(*(graph.cdt), *(graph.boundaryPolygon), face, vertex_index, neighbor_vertex_index);
 
-            if (face != nullptr) {
-                if (utils::is_obtuse(face->vertex(0)->point(), face->vertex(1)->point(), face->vertex(2)->point())) {
+            if (neighbor != nullptr) {
+                if (U::is_obtuse(neighbor->vertex(0)->point(), neighbor->vertex(1)->point(), neighbor->vertex(2)->point())) {
                     counter++;
                 }
             }
@@ -181,14 +154,35 @@ private:
         return counter;
     }
 
-    int selectMethodByProbability(Graph& graph, vector<steiner_stategies::Strategy>& strategies, CDT::Face_handle& face, Pheromones& pheromones, float xi, float psi) {
-        Point a = face->vertex(0)->point();
-        Point b = face->vertex(1)->point();
-        Point c = face->vertex(2)->point();
+    // Heuristic inputs of a face; read-only, so computed for all ants in parallel
+    struct FaceHeuristics {
+        int adjacent_obtuse_count = 0;
+        float p = 0;
+    };
+
+    vector<FaceHeuristics> computeHeuristics(Graph& graph, vector<CDT::Face_handle>& faces) {
+        vector<FaceHeuristics> heuristics(faces.size());
+
+        for (CDT::Face_handle face : faces) { // the workers below only read the cached coordinates
+            for (int k = 0; k < 3; k++) {
+                utils::approximate(face->vertex(k));
+            }
+        }
 
-        int adjacent_obtuse_count = countObtuseNeighbors(graph, a, b, c);
+        parallel_scan::parallel_for(faces.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                heuristics[i].adjacent_obtuse_count = countObtuseNeighbors(graph, faces[i]);
+                heuristics[i].p = utils::radius_to_height_ratio(faces[i]);
+            }
+        });
 
-        float p = radius_to_height_ratio(a, b, c);
+        return heuristics;
+    }
+
+    int selectMethodByProbability(vector<steiner_stategies::Strategy>& strategies, const FaceHeuristics& heuristics, Pheromones& pheromones, float xi, float psi) {
+        int adjacent_obtuse_count = heuristics.adjacent_obtuse_count;
+
+        float p = heuristics.p;
 
         float h_vertex_projection = heuristic_function_vertex_projection(p);
         float h_circumcenter = heuristic_function_circumcenter(p);
@@ -268,6 +262,7 @@ public:
 
         unsigned int total_methods = strategies.size();
         Pheromones pheromones(total_methods);
+        ExactCollapse collapse;
 
         int MAX_ITERATIONS = loader.getL();
         float xi = loader.getXi();
@@ -275,13 +270,15 @@ public:
         float lambda = loader.getLambda();
         float kappa = loader.getKappa();
 
-        int obtuse_triangles_initial = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+        int obtuse_triangles_initial = U::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
         int obtuse_triangles_after = 0;
 
         int convergence_iterations = 0;
 
         bool local_minimum_reached = false;
 
+        TaskScheduler& scheduler = TaskScheduler::instance();
+
         cout << "# Initial Energy : " << calculateEnergy(alpha, beta, obtuse_triangles_initial, steinerPoints.size()) << endl;
         cout << "# Max iterations : " << MAX_ITERATIONS << endl;
         cout << "# Xi: " << xi << endl;
@@ -290,7 +287,7 @@ public:
         cout << "# Kappa : " << kappa << endl;
 
         for (int loop = 0; loop < MAX_ITERATIONS; loop++) { // Cycles ...
-            int obtuse_triangles_before = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+            int obtuse_triangles_before = U::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
             float E_current = calculateEnergy(alpha, beta, obtuse_triangles_before, steinerPoints.size());
             float E_next = 0;
 
@@ -298,25 +295,7 @@ public:
 
             cout << " *** Current Energy: " << E_current << ", Pheromones = [" << pheromones << "]" << endl;
 
-            std::vector<CDT::Face_handle> finite_faces; // all faces
-
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                finite_faces.push_back(fit);
-            }
-
-            std::vector<CDT::Face_handle> obtuse_finite_faces; // obtuse faces
-
-            for (auto fit : finite_faces) {
-                Point a = fit->vertex(0)->point();
-                Point b = fit->vertex(1)->point();
-                Point c = fit->vertex(2)->point();
-
-                bool result = utils::is_obtuse(a, b, c);
-
-                if (result) {
-                    obtuse_finite_faces.push_back(fit);
-                }
-            }
+            std::vector<CDT::Face_handle> obtuse_finite_faces = U::obtuseFaces(cdt); // obtuse faces
 
             if (obtuse_finite_faces.size() == 0) { // Stop if no obtuse faces left
                 break;
@@ -347,8 +326,10 @@ public:
             //
             vector<int> methodsPerAnt;
 
+            vector<FaceHeuristics> heuristicsPerAnt = computeHeuristics(graph, obtuse_finite_face_per_ant);
+
             for (int i = 0; i < workingAnts; i++) {
-                int m = selectMethodByProbability(graph, strategies, obtuse_finite_face_per_ant[i], pheromones, xi, psi);
+                int m = selectMethodByProbability(strategies, heuristicsPerAnt[i], pheromones, xi, psi);
 
                 methodsPerAnt.push_back(m);
             }
@@ -368,28 +349,29 @@ public:
                 cout << endl;
             }
 
-            vector<Point*> pointsPerAnt;
-            vector<float> energyPerAnt;
+            vector<Point*> pointsPerAnt(workingAnts, nullptr);
+            vector<float> energyPerAnt(workingAnts, 0);
+            vector<TrialResult> resultsPerAnt(workingAnts);
+            vector<Point*> candidatesPerAnt(workingAnts, nullptr);
+            vector<std::array<Point, 3>> cornersPerAnt(workingAnts); // read here, so that no task reads the live faces
 
             //
-            // For each ant find steiner point and energy
+            // For each ant find steiner point and energy: every candidate is
+            // generated on the live triangulation before any task starts
             //
             for (int i = 0; i < workingAnts; i++) {
                 CDT::Face_handle fit = obtuse_finite_face_per_ant[i];
                 Point a = fit->vertex(0)->point();
                 Point b = fit->vertex(1)->point();
                 Point c = fit->vertex(2)->point();
+
+                cornersPerAnt[i] = {a, b, c};
                 int N = methodsPerAnt[i];
 
                 steiner_stategies::Strategy& selected_strategy = strategies[N];
 
-                CDT cdt_copy = cdt;
-                Graph graph_copy;
-                graph_copy.cdt = &cdt_copy;
-                graph_copy.boundaryPolygon = graph.boundaryPolygon;
-
                 if (selected_strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
-                    int i = utils::find_obtuse_angle(a, b, c);                      // 0:a, 1:b, 2:c
+                    int i = U::find_obtuse_angle(a, b, c);                      // 0:a, 1:b, 2:c
                     if (i == -1) {
                         cout << "CRITICAL ERROR: find_obtuse_angle failed " << endl;
                         exit(1);
@@ -400,46 +382,47 @@ public:
                     Point& p1 = fit->vertex(std::get<0>(edge_indices))->point();
                     Point& p2 = fit->vertex(std::get<1>(edge_indices))->point();
 
-                    bool is_constraint = utils::checkConstraints(cdt_copy, boundaryPolygon, p1, p2);
+                    bool is_constraint = utils::checkConstraints(cdt, boundaryPolygon, p1, p2);
 
                     if (is_constraint) {
-                        pointsPerAnt.push_back(nullptr);
-                        energyPerAnt.push_back(0);
                         continue;
                     }
                 }
 
-                Point* s = steiner_stategies::generateSteinerPoint(graph_copy, a, b, c, selected_strategy);
+                Point* s = steiner_stategies::generateSteinerPoint(graph, a, b, c, selected_strategy, fit);
+
+                if (s != nullptr) { // only candidates that exist are applied to a copy
+                    bool inserted = utils::is_steiner_point_valid(boundaryPolygon, *s, cdt.domain_index);
 
-                if (s != nullptr) {
-                    if (utils::is_steiner_point_valid(boundaryPolygon, *s)) {
-                        cdt_copy.insertByStrategy(*s, selected_strategy);
-                        steiner_stategies::removeConflictPoints(graph_copy, a, b, c, selected_strategy);
+                    candidatesPerAnt[i] = s;
 
-                        pointsPerAnt.push_back(s);
-                    } else {
-                        pointsPerAnt.push_back(nullptr);
+                    if (inserted) {
+                        pointsPerAnt[i] = s;
                     }
+                }
+            }
 
-                    cout << " i = " << i << " , " << *s << endl;
+            TaskScheduler::Group evaluations;
 
-                    int copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt_copy, *(graph.boundaryPolygon));
+            for (int i = 0; i < workingAnts; i++) {
+                if (candidatesPerAnt[i] != nullptr) {
+                    scheduler.submit(evaluations, [&, i](unsigned int) {
+                        const std::array<Point, 3>& corners = cornersPerAnt[i];
 
-                    float E_next = calculateEnergy(alpha, beta, copy_obtuse_triangles_after, steinerPoints.size() + 1);
+                        evaluateTrial<U>(graph, corners[0], corners[1], corners[2], *candidatesPerAnt[i], strategies[methodsPerAnt[i]], pointsPerAnt[i] != nullptr, false, resultsPerAnt[i]);
+                    });
+                }
+            }
 
-                    energyPerAnt.push_back(E_next);
+            scheduler.wait(evaluations);
+
+            for (int i = 0; i < workingAnts; i++) {
+                if (candidatesPerAnt[i] != nullptr) {
+                    cout << " i = " << i << " , " << *candidatesPerAnt[i] << endl;
 
-                    // cout << "\t";
-                    // steiner_stategies::printStrategy(selected_strategy);
-                    // cout << " - New energy: " << E_next << " - Method succeeded " << copy_obtuse_triangles_after << endl;
+                    energyPerAnt[i] = calculateEnergy(alpha, beta, resultsPerAnt[i].obtuse_triangles, steinerPoints.size() + 1);
 
                     // --------------------------------------------------------- energy
-                } else {
-                    // cout << "\t";
-                    // steiner_stategies::printStrategy(selected_strategy);
-                    // cout << " - New energy: " << E_next << " - Method failed    " << endl;
-                    energyPerAnt.push_back(0);
-                    pointsPerAnt.push_back(nullptr);
                 }
             }
 
@@ -464,45 +447,57 @@ public:
             //
             // Find conflicts - Save best triangulation by comparing 2 ants each time
             //
+
+            // A pair conflicts when its two insertion orders disagree, which does not
+            // depend on the other pairs: every pair is tested by a task, and the
+            // ants are then dropped pair by pair as before
+            vector<char> conflictsPerPair(workingAnts * workingAnts, 0);
+            TaskScheduler::Group pairs;
+
             for (int i = 0; i < workingAnts; i++) {
                 for (int j = i + 1; j < workingAnts; j++) {
                     if (pointsPerAnt[i] != nullptr && pointsPerAnt[j] != nullptr) {
-                        int selected_strategy1 = methodsPerAnt[i];
-                        int selected_strategy2 = methodsPerAnt[j];
-                        Point* s1 = pointsPerAnt[i];
-                        Point* s2 = pointsPerAnt[j];
-                        float energy1 = energyPerAnt[i];
-                        float energy2 = energyPerAnt[j];
-
-                        Point a1 = obtuse_finite_face_per_ant[i]->vertex(0)->point();
-                        Point b1 = obtuse_finite_face_per_ant[i]->vertex(1)->point();
-                        Point c1 = obtuse_finite_face_per_ant[i]->vertex(2)->point();
-
-                        Point a2 = obtuse_finite_face_per_ant[j]->vertex(0)->point();
-                        Point b2 = obtuse_finite_face_per_ant[j]->vertex(1)->point();
-                        Point c2 = obtuse_finite_face_per_ant[j]->vertex(2)->point();
-
-                        CDT cdt_copy_1 = cdt;
-                        CDT cdt_copy_2 = cdt;
-
-                        cdt_copy_1.insertByStrategy(*s1, selected_strategy1);
-                        steiner_stategies::removeConflictPoints(cdt_copy_1, a1, b1, c1, selected_strategy1);
-
-                        cdt_copy_1.insertByStrategy(*s2, selected_strategy1);
-                        steiner_stategies::removeConflictPoints(cdt_copy_1, a2, b2, c2, selected_strategy1);
-
-                        cdt_copy_2.insertByStrategy(*s2, selected_strategy2);
-                        steiner_stategies::removeConflictPoints(cdt_copy_2, a2, b2, c2, selected_strategy2);
-
-                        cdt_copy_2.insertByStrategy(*s1, selected_strategy2);
-                        steiner_stategies::removeConflictPoints(cdt_copy_2, a1, b1, c1, selected_strategy2);
-
-                        if (cdt_copy_1 != cdt_copy_2) {
-                            if (energy1 < energy2) {
-                                pointsPerAnt[j] = nullptr;
-                            } else {
-                                pointsPerAnt[i] = nullptr;
-                            }
+                        scheduler.submit(pairs, [&, i, j](unsigned int) {
+                            int selected_strategy1 = methodsPerAnt[i];
+                            int selected_strategy2 = methodsPerAnt[j];
+                            Point* s1 = pointsPerAnt[i];
+                            Point* s2 = pointsPerAnt[j];
+
+                            auto [a1, b1, c1] = cornersPerAnt[i];
+                            auto [a2, b2, c2] = cornersPerAnt[j];
+
+                            CDT cdt_copy_1 = *graph.cdt;
+                            CDT cdt_copy_2 = *graph.cdt;
+
+                            Graph graph_copy_1;
+                            graph_copy_1.cdt = &cdt_copy_1;
+                            graph_copy_1.boundaryPolygon = graph.boundaryPolygon;
+
+                            Graph graph_copy_2;
+                            graph_copy_2.cdt = &cdt_copy_2;
+                            graph_copy_2.boundaryPolygon = graph.boundaryPolygon;
+
+                            steiner_stategies::applySteinerPoint(graph_copy_1, a1, b1, c1, *s1, selected_strategy1);
+                            steiner_stategies::applySteinerPoint(graph_copy_1, a2, b2, c2, *s2, selected_strategy1);
+
+                            steiner_stategies::applySteinerPoint(graph_copy_2, a2, b2, c2, *s2, selected_strategy2);
+                            steiner_stategies::applySteinerPoint(graph_copy_2, a1, b1, c1, *s1, selected_strategy2);
+
+                            conflictsPerPair[i * workingAnts + j] = (cdt_copy_1 != cdt_copy_2);
+                        });
+                    }
+                }
+            }
+
+            scheduler.wait(pairs);
+
+            for (int i = 0; i < workingAnts; i++) {
+                for (int j = i + 1; j < workingAnts; j++) {
+                    if (pointsPerAnt[i] != nullptr && pointsPerAnt[j] != nullptr && conflictsPerPair[i * workingAnts + j]) {
+                        if (energyPerAnt[i] < energyPerAnt[j]) {
+                            pointsPerAnt[j] = nullptr;
+                        } else {
+                            pointsPerAnt[i] = nullptr;
                         }
                     }
                 }
@@ -512,6 +507,14 @@ public:
             // Find combined energy
             //
             CDT cdt_copy = cdt;
+            Graph graph_copy;
+            graph_copy.cdt = &cdt_copy;
+            graph_copy.boundaryPolygon = graph.boundaryPolygon;
+
+            vector<Vertex_handle> verticesPerAnt(workingAnts); // in cdt_copy, committed by swap
+            vector<unsigned int> depthsPerAnt(workingAnts);
+            bool vertices_removed = false;
+
             for (int i = 0; i < workingAnts; i++) {
                 if (pointsPerAnt[i] != nullptr) {
                     int selected_strategy = methodsPerAnt[i];
@@ -521,13 +524,18 @@ public:
                     Point b1 = obtuse_finite_face_per_ant[i]->vertex(1)->point();
                     Point c1 = obtuse_finite_face_per_ant[i]->vertex(2)->point();
 
-                    cdt_copy.insertByStrategy(*s, selected_strategy);
+                    const unsigned int vertices_before = cdt_copy.number_of_vertices();
+
+                    depthsPerAnt[i] = ExactCollapse::derived_depth(obtuse_finite_face_per_ant[i]);
+                    verticesPerAnt[i] = steiner_stategies::applySteinerPoint(graph_copy, a1, b1, c1, *s, selected_strategy);
 
-                    steiner_stategies::removeConflictPoints(cdt_copy, a1, b1, c1, selected_strategy);
+                    if (cdt_copy.number_of_vertices() <= vertices_before) {
+                        vertices_removed = true;
+                    }
                 }
             }
 
-            int copy_obtuse_triangles_after_all_ants = utils::countObtuseTriangles(cdt_copy, *(graph.boundaryPolygon));
+            int copy_obtuse_triangles_after_all_ants = U::countObtuseTriangles(cdt_copy, *(graph.boundaryPolygon));
             int added_points = 0;
 
             for (int i = 0; i < workingAnts; i++) {
@@ -542,21 +550,16 @@ public:
 
             if (E_next_all_ants < E_current) {
                 //
-                // Apply triangulation
+                // Apply triangulation: the combined copy is exactly the evaluated state
                 //
+                cdt.swap(cdt_copy);
+
                 for (int i = 0; i < workingAnts; i++) {
                     if (pointsPerAnt[i] != nullptr) {
-                        int selected_strategy = methodsPerAnt[i];
-                        Point* s = pointsPerAnt[i];
-
-                        Point a = obtuse_finite_face_per_ant[i]->vertex(0)->point();
-                        Point b = obtuse_finite_face_per_ant[i]->vertex(1)->point();
-                        Point c = obtuse_finite_face_per_ant[i]->vertex(2)->point();
-
-                        cdt.insertByStrategy(*s, selected_strategy);
-                        steiner_stategies::removeConflictPoints(graph, a, b, c, selected_strategy);
+                        // a removal may have taken earlier points with it
+                        collapse.commit(cdt, vertices_removed ? Vertex_handle() : verticesPerAnt[i], depthsPerAnt[i]);
 
-                        steinerPoints.push_back(*s);
+                        steinerPoints.push_back(*pointsPerAnt[i]);
                     }
                 }
 
@@ -572,7 +575,7 @@ public:
                 //
                 // Update pheromones
                 //
-                obtuse_triangles_after = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+                obtuse_triangles_after = U::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
 
                 int reduced_obtuse_triangles = obtuse_triangles_after - obtuse_triangles_before;
 
@@ -598,7 +601,7 @@ public:
 
             cout << " Energy: " << E_current << " updated to " << E_next << endl;
 
-            int x = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+            int x = U::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
 
             int reduced_obtuse_triangles = obtuse_triangles_after - x;
 
@@ -621,7 +624,7 @@ public:
 
         double p = utils::average(pn);
 
-        obtuse_triangles_after = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+        obtuse_triangles_after = U::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
 
         cout << "***********************************************************************" << endl;
         cout << " - Initial obtuse triangles   : " << obtuse_triangles_initial << endl;
@@ -634,6 +637,7 @@ public:
         cout << " - Alpha                      : " << alpha << endl;
         cout << " - Beta                       : " << beta << endl;
         cout << " - Convergence rate metric   : " << p << endl;
+        collapse.print();
         cout << "***********************************************************************" << endl;
 
         return steinerPoints;
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "BoundaryIndex.h"
+#include "cgal_definitions.h"
+
+using namespace std;
+
+// Marks a cell centre whose status has not been computed yet
+static const int UNKNOWN_SIDE = 2;
+
+BoundaryIndex::BoundaryIndex(const Polygon_2& polygon) : polygon(polygon), fast(0), fallback(0) {
+    size_t n = polygon.size();
+
+    min_x = min_y = std::numeric_limits<double>::infinity();
+    max_x = max_y = -std::numeric_limits<double>::infinity();
+
+    for (auto vertex = polygon.vertices_begin(); vertex != polygon.vertices_end(); ++vertex) {
+        const Point& p = *vertex;
+
+        std::pair<double, double> x = CGAL::to_interval(p.x());
+        std::pair<double, double> y = CGAL::to_interval(p.y());
+
+        min_x = std::min(min_x, x.first);
+        max_x = std::max(max_x, x.second);
+        min_y = std::min(min_y, y.first);
+        max_y = std::max(max_y, y.second);
+    }
+
+    double width = max_x - min_x;
+    double height = max_y - min_y;
+
+    if (n < 3 || !(width > 0) || !(height > 0)) { // degenerate: every query uses bounded_side
+        columns = rows = 0;
+        cell_width = cell_height = margin = 0;
+        return;
+    }
+
+    // About two cells per edge, roughly square
+    double cells_wanted = 2.0 * n;
+
+    columns = std::max(1, (int)std::ceil(std::sqrt(cells_wanted * width / height)));
+    rows = std::max(1, (int)std::ceil(cells_wanted / columns));
+
+    cell_width = width / columns;
+    cell_height = height / rows;
+
+    margin = 1e-3 * std::max(cell_width, cell_height);
+
+    cells.resize((size_t)columns * rows);
+    centre_status.reset(new atomic<int>[cells.size()]);
+
+    for (size_t i = 0; i < cells.size(); i++) {
+        centre_status[i].store(UNKNOWN_SIDE);
+    }
+
+    for (size_t e = 0; e < n; e++) {
+        const Point& s = polygon[e];
+        const Point& t = polygon[(e + 1) % n];
+
+        std::pair<double, double> sx = CGAL::to_interval(s.x()), sy = CGAL::to_interval(s.y());
+        std::pair<double, double> tx = CGAL::to_interval(t.x()), ty = CGAL::to_interval(t.y());
+
+        // Every cell whose margin-expanded box meets the edge's bounding box
+        int c0 = column_of(std::min(sx.first, tx.first) - margin);
+        int c1 = column_of(std::max(sx.second, tx.second) + margin);
+        int r0 = row_of(std::min(sy.first, ty.first) - margin);
+        int r1 = row_of(std::max(sy.second, ty.second) + margin);
+
+        for (int r = r0; r <= r1; r++) {
+            for (int c = c0; c <= c1; c++) {
+                cells[(size_t)r * columns + c].push_back((int)e);
+            }
+        }
+    }
+}
+
+int BoundaryIndex::column_of(double x) const {
+    return std::min(columns - 1, std::max(0, (int)std::floor((x - min_x) / cell_width)));
+}
+
+int BoundaryIndex::row_of(double y) const {
+    return std::min(rows - 1, std::max(0, (int)std::floor((y - min_y) / cell_height)));
+}
+
+Point BoundaryIndex::centre(int cell) const {
+    int r = cell / columns;
+    int c = cell % columns;
+
+    return Point(min_x + (c + 0.5) * cell_width, min_y + (r + 0.5) * cell_height);
+}
+
+CGAL::Bounded_side BoundaryIndex::centre_side(int cell) const {
+    int side = centre_status[cell].load(std::memory_order_relaxed);
+
+    if (side == UNKNOWN_SIDE) { // racing threads compute the same value
+        side = polygon.bounded_side(centre(cell));
+
+        centre_status[cell].store(side, std::memory_order_relaxed);
+    }
+
+    return (CGAL::Bounded_side)side;
+}
+
+CGAL::Bounded_side BoundaryIndex::exact(const Point& p) const {
+    fallback.fetch_add(1, std::memory_order_relaxed);
+
+    return polygon.bounded_side(p);
+}
+
+CGAL::Bounded_side BoundaryIndex::bounded_side(const Point& p) const {
+    if (columns == 0) {
+        return exact(p);
+    }
+
+    std::pair<double, double> x = CGAL::to_interval(p.x());
+    std::pair<double, double> y = CGAL::to_interval(p.y());
+
+    if (x.second < min_x || x.first > max_x || y.second < min_y || y.first > max_y) { // outside the bounding box
+        fast.fetch_add(1, std::memory_order_relaxed);
+        return CGAL::ON_UNBOUNDED_SIDE;
+    }
+
+    if (x.second - x.first > 0.5 * margin || y.second - y.first > 0.5 * margin) { // too uncertain to pick a cell
+        return exact(p);
+    }
+
+    int cell = row_of(CGAL::to_double(p.y())) * columns + column_of(CGAL::to_double(p.x()));
+
+    CGAL::Bounded_side side = centre_side(cell);
+
+    if (side == CGAL::ON_BOUNDARY) {
+        return exact(p);
+    }
+
+    const vector<int>& edges = cells[cell];
+
+    if (edges.empty()) {
+        fast.fetch_add(1, std::memory_order_relaxed);
+        return side;
+    }
+
+    // Parity of the crossings between the segment centre-p and the cell's edges
+    Point c = centre(cell);
+    bool inside = (side == CGAL::ON_BOUNDED_SIDE);
+    size_t n = polygon.size();
+
+    for (int e : edges) {
+        const Point& s = polygon[e];
+        const Point& t = polygon[(e + 1) % n];
+
+        CGAL::Orientation o_p = CGAL::orientation(s, t, p);
+        CGAL::Orientation o_c = CGAL::orientation(s, t, c);
+
+        if (o_p == CGAL::COLLINEAR) {
+            if (CGAL::collinear_are_ordered_along_line(s, p, t)) {
+                fast.fetch_add(1, std::memory_order_relaxed);
+                return CGAL::ON_BOUNDARY;
+            }
+
+            if (o_c == CGAL::COLLINEAR) { // the segment runs along the edge's line
+                return exact(p);
+            }
+
+            continue; // touches the line outside the edge
+        }
+
+        if (o_c == CGAL::COLLINEAR) {
+            return exact(p);
+        }
+
+        if (o_p == o_c) {
+            continue;
+        }
+
+        CGAL::Orientation o_s = CGAL::orientation(c, p, s);
+        CGAL::Orientation o_t = CGAL::orientation(c, p, t);
+
+        if (o_s == CGAL::COLLINEAR || o_t == CGAL::COLLINEAR) { // passes through a vertex
+            return exact(p);
+        }
+
+        if (o_s != o_t) {
+            inside = !inside;
+        }
+    }
+
+    fast.fetch_add(1, std::memory_order_relaxed);
+
+    return inside ? CGAL::ON_BOUNDED_SIDE : CGAL::ON_UNBOUNDED_SIDE;
+}
+
+static double distance_to_segment(double px, double py, const Point& s, const Point& t) {
+    double ax = CGAL::to_double(s.x()), ay = CGAL::to_double(s.y());
+    double dx = CGAL::to_double(t.x()) - ax, dy = CGAL::to_double(t.y()) - ay;
+    double length = dx * dx + dy * dy;
+    double u = (length > 0) ? std::max(0.0, std::min(1.0, ((px - ax) * dx + (py - ay) * dy) / length)) : 0.0;
+
+    return std::hypot(px - (ax + u * dx), py - (ay + u * dy));
+}
+
+bool BoundaryIndex::near(const Point& p, double distance) const {
+    double x = CGAL::to_double(p.x());
+    double y = CGAL::to_double(p.y());
+    size_t n = polygon.size();
+
+    if (columns == 0) { // degenerate: every edge
+        for (size_t e = 0; e < n; e++) {
+            if (distance_to_segment(x, y, polygon[e], polygon[(e + 1) % n]) <= distance) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    if (x + distance < min_x || x - distance > max_x || y + distance < min_y || y - distance > max_y) {
+        return false;
+    }
+
+    // An edge that close has its bounding box, and so one of its cells, in the box around p
+    int c0 = column_of(x - distance), c1 = column_of(x + distance);
+    int r0 = row_of(y - distance), r1 = row_of(y + distance);
+
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            for (int e : cells[(size_t)r * columns + c]) {
+                if (distance_to_segment(x, y, polygon[e], polygon[(e + 1) % n]) <= distance) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
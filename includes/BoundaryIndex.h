@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+
+using namespace std;
+
+//
+// Point location against a fixed polygon in O(1) expected time. The bounding
+// box is cut into a uniform grid and every cell lists the edges that come
+// near it. A cell without edges lies entirely on one side of the boundary;
+// otherwise the status of the cell centre is flipped once per edge crossed on
+// the way from the centre to the query. Both are exact: ties and touching
+// edges fall back to Polygon_2::bounded_side.
+//
+// The index is owned next to its polygon (main keeps both, the triangulation
+// points to them through CDT::domain and CDT::domain_index) and handed to the
+// utils boundary tests; tests of other polygons use bounded_side directly.
+//
+class BoundaryIndex {
+public:
+    explicit BoundaryIndex(const Polygon_2& polygon);
+
+    CGAL::Bounded_side bounded_side(const Point& p) const;
+
+    // Whether an edge comes within distance of p, in doubles; only looks at
+    // the cells that the box of that radius meets
+    bool near(const Point& p, double distance) const;
+
+    // Whether this is the index of polygon (the very object, not an equal copy)
+    bool indexes(const Polygon_2& polygon) const {
+        return &this->polygon == &polygon;
+    }
+
+    // Queries answered without bounded_side, and fallbacks
+    unsigned long fast_queries() const {
+        return fast;
+    }
+
+    unsigned long fallback_queries() const {
+        return fallback;
+    }
+
+private:
+    const Polygon_2& polygon; // must outlive the index and stay unchanged
+
+    double min_x, min_y, max_x, max_y; // contain every exact vertex
+    double cell_width, cell_height;
+    double margin; // edges are bucketed into every cell they come this close to
+    int columns, rows;
+
+    vector<vector<int>> cells; // edge indices per cell, row major
+
+    // Exact status of each cell centre, computed on first use
+    mutable unique_ptr<atomic<int>[]> centre_status;
+
+    mutable atomic<unsigned long> fast;
+    mutable atomic<unsigned long> fallback;
+
+    int column_of(double x) const;
+
+    int row_of(double y) const;
+
+    Point centre(int cell) const;
+
+    CGAL::Bounded_side centre_side(int cell) const;
+
+    CGAL::Bounded_side exact(const Point& p) const;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+
+using namespace std;
+
+//
+// Memo table for candidate evaluations. An entry is keyed by the vertices of
+// the obtuse face and the strategy, and remembers the change in obtuse
+// triangles the candidate produced. Each entry also records the version of
+// every vertex in the candidate's footprint (the faces it modified); a commit
+// bumps the versions of the vertices it touched, so only entries whose
+// footprint overlaps a committed change are invalidated.
+//
+// Vertices are identified by VertexInfo::index, which copies of the
+// triangulation share, so entries stay valid when an evaluated copy is
+// swapped in for the live triangulation.
+//
+class CandidateCache {
+public:
+    typedef std::array<unsigned long, 3> FaceKey;
+
+    enum Outcome {
+        EVALUATED = 0, // obtuse_delta is valid
+        FAILED,        // the strategy produced no point
+        SKIPPED,       // the strategy is not applicable to the face
+    };
+
+    struct Entry {
+        Outcome outcome;
+        int obtuse_delta;
+        vector<std::pair<unsigned long, unsigned int>> footprint;
+    };
+
+    unsigned int hits = 0;
+    unsigned int misses = 0;
+    unsigned int invalidations = 0;
+
+    static FaceKey key(CDT::Face_handle face) {
+        FaceKey k = {face->vertex(0)->info().index, face->vertex(1)->info().index, face->vertex(2)->info().index};
+        std::sort(k.begin(), k.end());
+        return k;
+    }
+
+    Entry* lookup(const FaceKey& face, int strategy) {
+        auto it = entries.find(std::make_pair(face, strategy));
+
+        if (it == entries.end()) {
+            misses++;
+            return nullptr;
+        }
+
+        for (const auto& [index, stamp] : it->second.footprint) {
+            if (version(index) != stamp) {
+                entries.erase(it);
+                invalidations++;
+                misses++;
+                return nullptr;
+            }
+        }
+
+        hits++;
+        return &(it->second);
+    }
+
+    void store(const FaceKey& face, int strategy, Outcome outcome, int obtuse_delta, const vector<Vertex_handle>& footprint) {
+        Entry& entry = entries[std::make_pair(face, strategy)];
+
+        entry.outcome = outcome;
+        entry.obtuse_delta = obtuse_delta;
+        entry.footprint.clear();
+
+        for (const Vertex_handle& v : footprint) {
+            entry.footprint.emplace_back(v->info().index, version(v->info().index));
+        }
+    }
+
+    // Call before the vertices change (or are removed) on the live triangulation
+    void touch(const vector<Vertex_handle>& vertices) {
+        for (const Vertex_handle& v : vertices) {
+            versions[v->info().index]++;
+        }
+    }
+
+    void clear() {
+        entries.clear();
+        versions.clear();
+    }
+
+    void print() const {
+        cout << " - Candidate cache hits      : " << hits << endl;
+        cout << " - Candidate cache misses    : " << misses << endl;
+        cout << " - Candidate cache evictions : " << invalidations << endl;
+    }
+
+private:
+    map<std::pair<FaceKey, int>, Entry> entries;
+    map<unsigned long, unsigned int> versions;
+
+    unsigned int version(unsigned long index) const {
+        auto it = versions.find(index);
+        return (it == versions.end()) ? 0 : it->second;
+    }
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <numeric>
+#include <unordered_set>
+#include <vector>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+#include <CGAL/Spatial_sort_traits_adapter_2.h>
+#include <CGAL/hilbert_sort.h>
+#include <CGAL/property_map.h>
+
+// Support classes
+#include "ExactCollapse.h"
+#include "graph_definitions.h"
+#include "steiner_strategies.h"
+#include "utils.hpp"
+
+using namespace std;
+
+//
+// Improving Steiner points chosen against the same state of the live
+// triangulation, inserted together once the batch is full or the sweep
+// ends. A point joins only when its footprint (utils::candidateFootprint)
+// shares no vertex with the footprints already batched and its strategy
+// inserts without flips (strategy > 0): the insertions then destroy disjoint
+// faces, each keeps the outcome it was evaluated with, and the changes in
+// obtuse triangles add up. The faces stay valid until the commit for the
+// same reason, so every insertion is located from its own face.
+//
+// While a batch is pending the live triangulation must not change any other
+// way: engines defer candidates that cannot join.
+//
+class CommitBatch {
+public:
+    struct Entry {
+        CDT::Face_handle face; // the obtuse face the point was generated from
+        Point point;
+        steiner_stategies::Strategy strategy;
+        int obtuse_delta; // change in obtuse triangles measured on a copy
+        vector<Vertex_handle> footprint;
+    };
+
+    unsigned int commits = 0; // batches committed
+    unsigned int points = 0;  // points inserted by them
+
+    explicit CommitBatch(size_t capacity) : capacity(capacity) {
+    }
+
+    // A capacity of 1 commits every point on its own, as without batching
+    bool enabled() const {
+        return capacity > 1;
+    }
+
+    bool empty() const {
+        return entries.empty();
+    }
+
+    bool full() const {
+        return entries.size() >= capacity;
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    // Change in obtuse triangles once the pending points are inserted
+    int obtuse_delta() const {
+        int delta = 0;
+
+        for (const Entry& entry : entries) {
+            delta += entry.obtuse_delta;
+        }
+
+        return delta;
+    }
+
+    bool admits(steiner_stategies::Strategy strategy, const vector<Vertex_handle>& footprint) const {
+        if (!enabled() || full() || strategy <= 0) {
+            return false;
+        }
+
+        for (Vertex_handle v : footprint) {
+            if (claimed.count(v->info().index) > 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void add(CDT::Face_handle face, const Point& point, steiner_stategies::Strategy strategy, int obtuse_delta, const vector<Vertex_handle>& footprint) {
+        entries.push_back(Entry{face, point, strategy, obtuse_delta, footprint});
+
+        for (Vertex_handle v : footprint) {
+            claimed.insert(v->info().index);
+        }
+    }
+
+    // Inserts the pending points along a Hilbert curve, so that consecutive
+    // insertions touch nearby memory, then calls committed(entry, v, depth)
+    // for each new vertex v generated at construction depth depth
+    template <class Callback>
+    void commit(Graph& graph, Callback committed) {
+        typedef CGAL::Exact_predicates_inexact_constructions_kernel Epick;
+        typedef CGAL::Spatial_sort_traits_adapter_2<Epick, CGAL::Pointer_property_map<Epick::Point_2>::const_type> Traits;
+
+        if (entries.empty()) {
+            return;
+        }
+
+        vector<Epick::Point_2> positions;
+
+        for (const Entry& entry : entries) {
+            positions.emplace_back(CGAL::to_double(entry.point.x()), CGAL::to_double(entry.point.y()));
+        }
+
+        vector<std::ptrdiff_t> order(entries.size());
+
+        std::iota(order.begin(), order.end(), 0);
+
+        CGAL::hilbert_sort(order.begin(), order.end(), Traits(CGAL::make_property_map(positions)));
+
+        for (std::ptrdiff_t i : order) {
+            Entry& entry = entries[i];
+
+            Point a = entry.face->vertex(0)->point();
+            Point b = entry.face->vertex(1)->point();
+            Point c = entry.face->vertex(2)->point();
+
+            const unsigned int depth = ExactCollapse::derived_depth(entry.face);
+
+            Vertex_handle v = steiner_stategies::applySteinerPoint(graph, a, b, c, entry.point, entry.strategy, entry.face);
+
+            committed(entry, v, depth);
+        }
+
+        commits++;
+        points += entries.size();
+
+        entries.clear();
+        claimed.clear();
+    }
+
+    void print() const {
+        if (enabled()) {
+            cout << " - Batched commits           : " << points << " points in " << commits << " batches" << endl;
+        }
+    }
+
+private:
+    size_t capacity;
+    vector<Entry> entries;
+    unordered_set<unsigned long> claimed; // vertex indices of the pending footprints
+};
@@ -1,6 +1,14 @@
 #pragma once
 
 #include <CGAL/Constrained_Delaunay_triangulation_2.h>
+#include <CGAL/Polygon_2.h>
+
+#include <utility>
+
+#include "LocateGrid.h"
+#include "triangulation_configuration.h"
+
+class BoundaryIndex;
 
 template <class Gt, class Tds = CGAL::Default, class Itag = CGAL::Default>
 class CustomConstrainedDelaunayTriangulation_2 : public CGAL::Constrained_Delaunay_triangulation_2<Gt, Tds, Itag> {
@@ -12,6 +20,15 @@ public:
     using typename Base::Vertex_handle;
     using typename Base::Locate_type;
 
+    // Boundary the faces' in-domain flags refer to (set by utils::markDomain);
+    // without one every finite face is in the domain
+    const CGAL::Polygon_2<Gt>* domain = nullptr;
+
+    // Index of domain for the boundary tests, owned with it; nullptr scans the polygon
+    const BoundaryIndex* domain_index = nullptr;
+
+    // Start unhinted point locations from the jump-and-walk grid
+    bool use_locate_grid = USE_LOCATE_GRID;
 
 
     // Constructors
@@ -26,6 +43,116 @@ public:
     template <class InputIterator>
     CustomConstrainedDelaunayTriangulation_2(InputIterator it, InputIterator last, const Gt& gt = Gt()) : Base(it, last, gt) {}
 
+    // Copies leave the grid behind: its handles point into the original
+    CustomConstrainedDelaunayTriangulation_2(const CustomConstrainedDelaunayTriangulation_2& other) : Base(other), domain(other.domain), domain_index(other.domain_index), use_locate_grid(other.use_locate_grid) {}
+
+    CustomConstrainedDelaunayTriangulation_2& operator=(const CustomConstrainedDelaunayTriangulation_2& other) {
+        if (this != &other) {
+            Base::operator=(other);
+            domain = other.domain;
+            domain_index = other.domain_index;
+            use_locate_grid = other.use_locate_grid;
+            grid.clear();
+        }
+
+        return *this;
+    }
+
+    // The grid follows the vertices it refers to, the domain the faces it flags
+    void swap(CustomConstrainedDelaunayTriangulation_2& other) {
+        Base::swap(other);
+        std::swap(grid, other.grid);
+        std::swap(domain, other.domain);
+        std::swap(domain_index, other.domain_index);
+        std::swap(use_locate_grid, other.use_locate_grid);
+    }
+
+    void clear() {
+        Base::clear();
+        grid.clear();
+    }
+
+    // Point location, starting from the grid when no start face is given
+    using Base::locate;
+
+    Face_handle locate(const Point& p, Locate_type& lt, int& li, Face_handle start = Face_handle()) const {
+        if (start == Face_handle()) {
+            start = jump(p);
+        }
+
+        return Base::locate(p, lt, li, start);
+    }
+
+    Face_handle locate(const Point& p, Face_handle start = Face_handle()) const {
+        Locate_type lt;
+        int li;
+
+        return locate(p, lt, li, start);
+    }
+
+    // A face near p to start a walk from, or a null handle. The grid is
+    // (re)built here once the triangulation is large enough or has doubled
+    // since the last build, so this is not safe to call from several threads.
+    Face_handle jump(const Point& p) const {
+        if (!use_locate_grid || this->dimension() < 2 || this->number_of_vertices() < LOCATE_GRID_MIN_VERTICES) {
+            return Face_handle();
+        }
+
+        if (!grid.built() || this->number_of_vertices() > 2 * grid.size()) {
+            grid.rebuild(this->finite_vertices_begin(), this->finite_vertices_end(), this->number_of_vertices());
+        }
+
+        Vertex_handle v = grid.nearest(p);
+
+        return (v == Vertex_handle()) ? Face_handle() : v->face();
+    }
+
+    void remove(Vertex_handle v) {
+        grid.remove(v);
+        Base::remove(v);
+    }
+
+    // Every insertion keeps the grid current, not only insertByStrategy
+    Vertex_handle insert(const Point& p, Face_handle start = Face_handle()) {
+        Locate_type lt;
+        int li;
+
+        Face_handle loc = this->locate(p, lt, li, start);
+
+        return insert(p, lt, loc, li);
+    }
+
+    Vertex_handle insert(const Point& p, Locate_type lt, Face_handle loc, int li) {
+        Vertex_handle v = Base::insert(p, lt, loc, li);
+
+        grid.insert(v);
+        mark_dirty(v);
+
+        return v;
+    }
+
+    // Range insertion (spatially sorted by CGAL): the grid is rebuilt on the next jump
+    template <class InputIterator>
+    std::ptrdiff_t insert(InputIterator first, InputIterator last) {
+        std::ptrdiff_t n = Base::insert(first, last);
+
+        grid.clear();
+
+        return n;
+    }
+
+    // A constraint only adds vertices where it crosses another one; the grid is rebuilt then
+    template <class... Args>
+    void insert_constraint(Args&&... args) {
+        const size_t vertices_before = this->number_of_vertices();
+
+        Base::insert_constraint(std::forward<Args>(args)...);
+
+        if (this->number_of_vertices() != vertices_before) {
+            grid.clear();
+        }
+    }
+
     // New insert method without flips
 
     Vertex_handle insert_no_flip(const Point& a, Face_handle start = Face_handle()) {
@@ -40,15 +167,84 @@ public:
     }
 
     void remove_no_flip(Vertex_handle v) {
+        grid.remove(v);
         this->Base::Ctr::remove(v);
     }
 
-    void insertByStrategy(const Point & p, int strategy) {
+    // hint: a face of this triangulation at or next to p. When it contains p no point
+    // location is needed at all; otherwise the walk starts there instead of at an
+    // arbitrary face.
+    Vertex_handle insertByStrategy(const Point & p, int strategy, Face_handle hint = Face_handle()) {
+        Vertex_handle v;
+        Locate_type lt;
+        int li = 0;
+
+        if (hint == Face_handle() || !contains(hint, p, lt, li)) {
+            hint = this->locate(p, lt, li, hint);
+        }
+
         if (strategy <= 0) {
-            CGAL::Constrained_Delaunay_triangulation_2<Gt, Tds, Itag>::insert(p);
+            v = CGAL::Constrained_Delaunay_triangulation_2<Gt, Tds, Itag>::insert(p, lt, hint, li);
         } else {
-            this->insert_no_flip(p);
+            v = this->insert_no_flip(p, lt, hint, li);
+        }
+
+        grid.insert(v);
+        mark_dirty(v);
+
+        return v;
+    }
+
+    // Whether p lies in the interior or on an edge of the finite face f, and where
+    bool contains(Face_handle f, const Point& p, Locate_type& lt, int& li) const {
+        if (this->dimension() < 2 || this->is_infinite(f)) {
+            return false;
+        }
+
+        int collinear = 0;
+
+        for (int i = 0; i < 3; i++) {
+            CGAL::Orientation o = this->orientation(f->vertex(this->ccw(i))->point(), f->vertex(this->cw(i))->point(), p);
+
+            if (o == CGAL::RIGHT_TURN) {
+                return false;
+            }
+
+            if (o == CGAL::COLLINEAR) {
+                collinear++;
+                li = i;
+            }
+        }
+
+        if (collinear == 0) {
+            lt = Base::FACE;
+            return true;
         }
+
+        if (collinear == 1) {
+            lt = Base::EDGE;
+            return true;
+        }
+
+        return false; // on a vertex: left to locate
     }
+
+    // Invalidates the cached face info around v: every face an insertion
+    // creates or flips is incident to the new vertex
+    void mark_dirty(Vertex_handle v) {
+        auto fc = this->incident_faces(v), done(fc);
+
+        if (fc == nullptr) {
+            return;
+        }
+
+        do {
+            fc->info().dirty = true;
+        } while (++fc != done);
+    }
+
+private:
+    // Representative vertices for jump(); empty until first needed
+    mutable LocateGrid<Vertex_handle> grid;
 };
 
@@ -0,0 +1,146 @@
+#pragma once
+
+// Standard C++
+#include <iostream>
+#include <vector>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+
+// Configuration
+#include "triangulation_configuration.h"
+
+// Support classes
+#include "graph_definitions.h"
+#include "search_traits.h"
+#include "utils.hpp"
+
+// Namespaces
+using namespace std;
+
+//
+// Zero-Steiner improvement: greedily flips the diagonal of a convex
+// quadrilateral of two domain faces when the two new triangles hold fewer
+// obtuse ones. Constrained edges, and so the boundary, are never flipped,
+// and a flip reuses both faces, so face handles and the domain flags stay
+// valid. Every flip lowers the obtuse count, which bounds the pass.
+//
+template <typename T>
+class EdgeFlipSearch {
+private:
+    unsigned long evaluated_flips = 0;
+    unsigned long applied_flips = 0;
+
+    static int obtuse(const Point& a, const Point& b, const Point& c) {
+        return T::is_obtuse(a, b, c) ? 1 : 0;
+    }
+
+    // Obtuse triangles removed by flipping edge i of face, or 0 when the flip is not allowed
+    int gain(CDT& cdt, CDT::Face_handle face, int i) {
+        CDT::Face_handle neighbor = face->neighbor(i);
+
+        if (cdt.is_constrained(CDT::Edge(face, i)) || !utils::in_domain(cdt, face) || !utils::in_domain(cdt, neighbor)) {
+            return 0;
+        }
+
+        const Point& p = face->vertex(i)->point();
+        const Point& q = face->vertex(cdt.ccw(i))->point();
+        const Point& s = face->vertex(cdt.cw(i))->point();
+        const Point& r = neighbor->vertex(cdt.mirror_index(face, i))->point();
+
+        // p, q, r, s is counterclockwise; the new faces p, q, r and p, r, s must be too
+        if (CGAL::orientation(p, q, r) != CGAL::LEFT_TURN || CGAL::orientation(p, r, s) != CGAL::LEFT_TURN) {
+            return 0;
+        }
+
+        evaluated_flips++;
+
+        return (obtuse(p, q, s) + obtuse(q, r, s)) - (obtuse(p, q, r) + obtuse(p, r, s));
+    }
+
+public:
+    // Flips until no flip lowers the obtuse count; returns the flips applied
+    unsigned long improve(Graph& graph) {
+        CDT& cdt = *(graph.cdt);
+
+        vector<CDT::Face_handle> stack = T::obtuseFaces(cdt);
+
+        unsigned long flips = 0;
+
+        while (!stack.empty()) {
+            CDT::Face_handle face = stack.back();
+
+            stack.pop_back();
+
+            if (!T::is_obtuse(face->vertex(0)->point(), face->vertex(1)->point(), face->vertex(2)->point())) { // fixed by an earlier flip
+                continue;
+            }
+
+            int best_gain = 0;
+            int best_edge = -1;
+
+            for (int i = 0; i < 3; i++) {
+                int g = gain(cdt, face, i);
+
+                if (g > best_gain) {
+                    best_gain = g;
+                    best_edge = i;
+                }
+            }
+
+            if (best_edge < 0) {
+                continue;
+            }
+
+            CDT::Face_handle neighbor = face->neighbor(best_edge);
+
+            cdt.flip(face, best_edge);
+
+            face->info().dirty = true;
+            neighbor->info().dirty = true;
+
+            flips++;
+
+            // The two new faces and the obtuse faces next to them may allow new flips
+            for (CDT::Face_handle changed : {face, neighbor}) {
+                stack.push_back(changed);
+
+                for (int i = 0; i < 3; i++) {
+                    CDT::Face_handle next = changed->neighbor(i);
+
+                    if (!cdt.is_infinite(next) && next != face && next != neighbor) {
+                        stack.push_back(next);
+                    }
+                }
+            }
+        }
+
+        applied_flips += flips;
+
+        return flips;
+    }
+
+    // The pass on its own: no Steiner points
+    vector<Point> triangulate(Graph& graph) {
+        CDT& cdt = *(graph.cdt);
+
+        int obtuse_triangles_initial = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+
+        improve(graph);
+
+        int obtuse_triangles_after = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+
+        cout << "***********************************************************************" << endl;
+        cout << " - Initial obtuse triangles  : " << obtuse_triangles_initial << endl;
+        cout << " - Total obtuse triangles    : " << obtuse_triangles_after << endl;
+        cout << " - Total steiner points      : " << 0 << endl;
+        print();
+        cout << "***********************************************************************" << endl;
+
+        return vector<Point>();
+    }
+
+    void print() const {
+        cout << " - Edge flips                : " << applied_flips << " of " << evaluated_flips << " evaluated" << endl;
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+
+// Configuration
+#include "triangulation_configuration.h"
+
+// Support classes
+#include "FaceSnapshot.h"
+
+using namespace std;
+
+//
+// Keeps the lazy Epeck coordinates of Steiner points shallow. A Steiner point
+// is a construction over the points of the face it was generated from, so its
+// expression DAG grows with every generation; predicates on deep DAGs fail
+// their interval filter more often and the DAGs keep every ancestor alive.
+// CGAL::exact() evaluates a coordinate once and prunes its DAG to a leaf.
+// Engines call commit() after inserting a Steiner point.
+//
+class ExactCollapse {
+public:
+    ExactCollapse() : exact_fallbacks_start(FaceSnapshot::exact_resolutions()) {
+    }
+
+    // Depth a point generated from face would have
+    static unsigned int derived_depth(CDT::Face_handle face) {
+        unsigned int depth = 0;
+
+        for (int k = 0; k < 3; k++) {
+            depth = std::max(depth, face->vertex(k)->info().depth);
+        }
+
+        return depth + 1;
+    }
+
+    // v may be a default handle when the strategy removed the new vertex again
+    void commit(CDT& cdt, Vertex_handle v, unsigned int depth) {
+        commits++;
+
+        max_depth = std::max(max_depth, depth);
+        total_depth += depth;
+
+        if (v != Vertex_handle()) {
+            v->info().depth = depth;
+
+            if (EXACT_COLLAPSE_ON_COMMIT) {
+                collapse(v);
+            }
+        }
+
+        if (EXACT_COLLAPSE_INTERVAL > 0 && commits % EXACT_COLLAPSE_INTERVAL == 0) {
+            collapse(cdt);
+        }
+    }
+
+    void collapse(CDT& cdt) {
+        passes++;
+
+        for (auto vit = cdt.finite_vertices_begin(); vit != cdt.finite_vertices_end(); ++vit) { // also catches points inserted outside commit()
+            collapse(vit);
+        }
+    }
+
+    void print() {
+        cout << " - Exact collapse            : " << collapsed_points << " points, " << passes << " full passes" << endl;
+        cout << " - Construction depth        : max " << max_depth << ", mean " << ((commits > 0) ? (double)total_depth / commits : 0.0) << endl;
+        cout << " - Exact fallbacks           : " << FaceSnapshot::exact_resolutions() - exact_fallbacks_start << " (face classification)" << endl;
+    }
+
+private:
+    unsigned long commits = 0;
+    unsigned long passes = 0;
+    unsigned long collapsed_points = 0;
+    unsigned long total_depth = 0;
+    unsigned int max_depth = 0;
+    unsigned long exact_fallbacks_start;
+
+    void collapse(Vertex_handle v) {
+        CGAL::exact(v->point()); // no-op for points that are exact already
+
+        if (v->info().depth > 0) {
+            collapsed_points++;
+        }
+
+        v->info().depth = 0;
+        v->info().approximated = false; // the interval is tight now
+    }
+};
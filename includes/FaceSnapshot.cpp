@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "cgal_definitions.h"
+#include "FaceSnapshot.h"
+#include "parallel_scan.h"
+#include "triangulation_configuration.h"
+#include "utils.hpp"
+
+using namespace std;
+
+static std::atomic<unsigned long> total_exact_resolutions(0);
+
+unsigned long FaceSnapshot::exact_resolutions() {
+    return total_exact_resolutions.load();
+}
+
+FaceSnapshot::FaceSnapshot(CDT& cdt) : faces(utils::domain_faces(cdt)) {
+    size_t n = faces.size();
+
+    utils::approximate(cdt); // once per vertex, before the parallel reads below
+
+    ax.resize(n), ay.resize(n);
+    bx.resize(n), by.resize(n);
+    cx.resize(n), cy.resize(n);
+    err.resize(n);
+
+    parallel_scan::parallel_for(n, PARALLEL_SCAN_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const VertexInfo& a = faces[i]->vertex(0)->info();
+            const VertexInfo& b = faces[i]->vertex(1)->info();
+            const VertexInfo& c = faces[i]->vertex(2)->info();
+
+            ax[i] = a.x, ay[i] = a.y;
+            bx[i] = b.x, by[i] = b.y;
+            cx[i] = c.x, cy[i] = c.y;
+
+            err[i] = std::max({a.err, b.err, c.err});
+        }
+    });
+}
+
+int FaceSnapshot::classify() {
+    face_classification::Batch batch{ax.data(), ay.data(), bx.data(), by.data(), cx.data(), cy.data(), err.data()};
+
+    status.assign(size(), face_classification::AMBIGUOUS);
+
+    // first: obtuse faces, second: faces resolved exactly
+    std::pair<int, unsigned int> counts = parallel_scan::parallel_reduce(size(), PARALLEL_SCAN_GRAIN, std::pair<int, unsigned int>(0, 0),
+        [&](size_t begin, size_t end) {
+            std::pair<int, unsigned int> local(0, 0);
+
+            face_classification::classify(batch, begin, end, status.data());
+
+            for (size_t i = begin; i < end; i++) {
+                if (status[i] == face_classification::AMBIGUOUS) { // the face info caches the exact answer
+                    if (!utils::has_cached_obtuse_angle(faces[i])) {
+                        local.second++;
+                    }
+
+                    status[i] = utils::is_obtuse(faces[i]) ? face_classification::OBTUSE : face_classification::NOT_OBTUSE;
+                }
+
+                if (status[i] == face_classification::OBTUSE) {
+                    local.first++;
+                }
+            }
+
+            return local;
+        },
+        [](const std::pair<int, unsigned int>& x, const std::pair<int, unsigned int>& y) {
+            return std::pair<int, unsigned int>(x.first + y.first, x.second + y.second);
+        });
+
+    ambiguous = counts.second;
+
+    total_exact_resolutions += ambiguous;
+
+    return counts.first;
+}
+
+vector<CDT::Face_handle> FaceSnapshot::obtuseFaces() const {
+    vector<CDT::Face_handle> result;
+
+    for (size_t i = 0; i < size(); i++) {
+        if (is_obtuse(i)) {
+            result.push_back(faces[i]);
+        }
+    }
+
+    return result;
+}
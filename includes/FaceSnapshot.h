@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+
+// Support classes
+#include "face_classification.h"
+
+using namespace std;
+
+//
+// Read-only copy of the faces of a triangulation inside its domain in structure-of-arrays
+// form: for face i, (ax[i], ay[i]) .. (cx[i], cy[i]) are double approximations
+// of its vertices and err[i] bounds their distance from the exact coordinates.
+// classify() labels every face in one vectorized pass and hands only the
+// ambiguous ones to the exact predicate. The snapshot is invalidated by any
+// change to the triangulation.
+//
+class FaceSnapshot {
+public:
+    vector<CDT::Face_handle> faces;
+
+    vector<double> ax, ay;
+    vector<double> bx, by;
+    vector<double> cx, cy;
+    vector<double> err;
+
+    vector<unsigned char> status; // face_classification::Status, filled by classify()
+
+    unsigned int ambiguous = 0; // faces resolved by the exact predicate
+
+    explicit FaceSnapshot(CDT& cdt);
+
+    size_t size() const {
+        return faces.size();
+    }
+
+    // Returns the number of obtuse faces
+    int classify();
+
+    bool is_obtuse(size_t i) const {
+        return status[i] == face_classification::OBTUSE;
+    }
+
+    vector<CDT::Face_handle> obtuseFaces() const;
+
+    // Faces resolved by the exact predicate over all snapshots so far
+    static unsigned long exact_resolutions();
+};
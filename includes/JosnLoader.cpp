@@ -34,6 +34,8 @@ void JsonLoader::load(const char* inputfile, bool load_hyperparameters) {
         additional_constraints.emplace_back(first, second);
     }
 
+    orthogonal = detectOrthogonal();
+
     // load method, parameters etc.
 
     if (load_hyperparameters) {
@@ -41,7 +43,7 @@ void JsonLoader::load(const char* inputfile, bool load_hyperparameters) {
         
         if (method == "legacy") {
             L = pt.get<int>("parameters.L");
-        } else if (method == "local") {
+        } else if (method == "local" || method == "parallel" || method == "qtls" || method == "ortholls") {
             L = pt.get<int>("parameters.L");
         } else if (method == "sa" || method == "sals") {
             L = pt.get<int>("parameters.L");
@@ -64,6 +66,7 @@ void JsonLoader::print() {
     std::cout << "Method      : " << method << "\n";
     std::cout << "Number of Points: " << num_points << "\n";
     std::cout << "Number of Constraints: " << num_constraints << "\n";
+    std::cout << "Orthogonal: " << (orthogonal ? "yes" : "no") << "\n";
 
     std::cout << "\nPoints X: ";
     for (int x : points_x) {
@@ -106,6 +109,42 @@ std::vector<int> JsonLoader::getRegionBoundaries() {
     return region_boundary;
 }
 
+const vector<int>& JsonLoader::getPointsX() const {
+    return points_x;
+}
+
+const vector<int>& JsonLoader::getPointsY() const {
+    return points_y;
+}
+
+bool JsonLoader::isOrthogonal() const {
+    return orthogonal;
+}
+
+bool JsonLoader::detectOrthogonal() const {
+    auto axis_aligned = [&](int i, int j) {
+        return (points_x[i] == points_x[j]) != (points_y[i] == points_y[j]); // exactly one coordinate shared
+    };
+
+    if (region_boundary.size() < 4) {
+        return false;
+    }
+
+    for (size_t i = 0; i < region_boundary.size(); i++) {
+        if (!axis_aligned(region_boundary[i], region_boundary[(i + 1) % region_boundary.size()])) {
+            return false;
+        }
+    }
+
+    for (const auto& constraint : additional_constraints) {
+        if (!axis_aligned(constraint.first, constraint.second)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 string JsonLoader::getInstance() const {
     return instance_uid;
 }
@@ -22,12 +22,18 @@ private:
     int num_constraints;
     vector<int> points_x, points_y, region_boundary;
     vector<std::pair<int, int>> additional_constraints;
+    bool orthogonal = false; // every boundary edge and constraint is axis-aligned
+
+    bool detectOrthogonal() const;
      
 public:
-    int L;   
+    int L = 0;
     float alpha, beta, xi, psi, lambda, kappa;  
     string method;
     bool randomize_on_deadend = false;
+    string strategy_selection = "ucb"; // ucb | exhaustive
+    string flip_pass = "none";         // none | pre | post | both
+    bool orthogonal_start = false;     // start the engines from OrthogonalMeshing on orthogonal instances
 
     void load(const char* inputfile, bool load_hyperparameters);
 
@@ -39,6 +45,13 @@ public:
 
     std::vector<int> getRegionBoundaries();    
 
+    // Integer input coordinates, for solvers that avoid exact number types
+    const vector<int>& getPointsX() const;
+
+    const vector<int>& getPointsY() const;
+
+    bool isOrthogonal() const;
+
     string getInstance() const;
 
     string getMethod() const;
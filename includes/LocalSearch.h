@@ -1,9 +1,13 @@
 #pragma once
 
 // Standard C++
+#include <atomic>
+#include <chrono>
 #include <gmp.h>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 // Macros and headers for CGAL
@@ -19,18 +23,127 @@
 #include "triangulation_configuration.h"
 
 // Support classes
+#include "CandidateCache.h"
+#include "CommitBatch.h"
+#include "ExactCollapse.h"
 #include "JsonExporter.h"
 #include "JsonLoader.h"
+#include "ObtuseFaceWorklist.h"
 #include "graph_definitions.h"
+#include "search_traits.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
 #include "RandomizationMethod.h"
+#include "StrategyBandit.h"
+#include "TaskScheduler.h"
+#include "TrialEvaluation.h"
 
 // Namespaces
 using namespace std;
 
 template <typename T>
 class LocalSearch {
+private:
+    // Whether a candidate removing at most `bound` obtuse triangles could still be the
+    // option selected below: the lowest count wins and ties go to the lowest strategy.
+    bool can_improve(map<steiner_stategies::Strategy, int>& options, steiner_stategies::Strategy strategy, int obtuse_triangles_before, int bound) {
+        if (bound <= 0) {
+            return false;
+        }
+
+        if (bound == std::numeric_limits<int>::max()) {
+            return true;
+        }
+
+        int best_possible = obtuse_triangles_before - bound;
+
+        for (const auto& [key, value] : options) {
+            if (value < best_possible || (value == best_possible && key < strategy)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // A generated candidate, evaluated by a scheduler task
+    struct Candidate {
+        steiner_stategies::Strategy strategy;
+        Point point;
+        bool inserted = false;
+        int bound = 0;
+        double generation_seconds = 0;
+        bool pruned = false; // by the tasks evaluated before it
+        TrialResult result;
+    };
+
+    // The options of a face known to its tasks: the cached ones, and the
+    // results of the candidates, by position in the strategy order. A task
+    // only looks at the candidates before its own, as a serial scan would.
+    class Best {
+    public:
+        explicit Best(size_t candidates) : results(candidates) {
+        }
+
+        // A cached option, known before any candidate
+        void seed(steiner_stategies::Strategy strategy, int value) {
+            if (beats(cached, strategy, value)) {
+                return;
+            }
+
+            cached = Option{strategy, value};
+        }
+
+        // Same rule as can_improve above, against the options before candidate k
+        bool can_improve(size_t k, steiner_stategies::Strategy strategy, int obtuse_triangles_before, int bound) {
+            lock_guard<std::mutex> lock(mutex);
+
+            if (bound == std::numeric_limits<int>::max()) {
+                return true;
+            }
+
+            return !beaten(k, strategy, obtuse_triangles_before - bound);
+        }
+
+        // Records the result of candidate k; whether no option before it is as good
+        bool offer(size_t k, steiner_stategies::Strategy strategy, int value) {
+            lock_guard<std::mutex> lock(mutex);
+
+            results[k] = Option{strategy, value};
+
+            return !beaten(k, strategy, value);
+        }
+
+    private:
+        struct Option {
+            steiner_stategies::Strategy strategy = steiner_stategies::Strategy::NONE;
+            int value = 0;
+        };
+
+        // Whether option is at least as good as value for strategy: lower, or as low and preferred
+        static bool beats(const Option& option, steiner_stategies::Strategy strategy, int value) {
+            return option.strategy != steiner_stategies::Strategy::NONE && (option.value < value || (option.value == value && option.strategy < strategy));
+        }
+
+        bool beaten(size_t k, steiner_stategies::Strategy strategy, int value) const {
+            if (beats(cached, strategy, value)) {
+                return true;
+            }
+
+            for (size_t i = 0; i < k; i++) {
+                if (beats(results[i], strategy, value)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        std::mutex mutex;
+        Option cached;
+        vector<Option> results;
+    };
+
 public:
     vector<Point> triangulate(vector<steiner_stategies::Strategy>& strategies, Graph& graph, JsonLoader& loader, Polygon& boundaryPolygon) {
         vector<Point> steinerPoints;
@@ -38,40 +151,56 @@ public:
         CDT& cdt = *(graph.cdt);
 
         int MAX_ITERATIONS = loader.getL();
-        int obtuse_triangles_initial = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+        int obtuse_triangles_initial = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
         int obtuse_triangles_before = 0;
         int obtuse_triangles_after = 0;
         int convergence_iterations = 0;
         bool local_minimum_reached = false;
 
+        int obtuse_triangles_current = obtuse_triangles_initial;
+
+        CandidateCache cache;
+        vector<Vertex_handle> footprint;
+
+        StrategyBandit bandit;
+        ExactCollapse collapse;
+        unsigned int pruned_candidates = 0;
+        unsigned int swapped_commits = 0;
+        bool use_bandit = loader.strategy_selection != "exhaustive";
+
+        ObtuseFaceWorklist worklist;
+        worklist.seed(cdt);
+
+        CommitBatch batch(COMMIT_BATCH_SIZE);
+        vector<CandidateCache::FaceKey> deferred; // winners that could not join the pending batch
+
+        TaskScheduler& scheduler = TaskScheduler::instance();
+
         cout << "# Max iterations: " << MAX_ITERATIONS << endl;
+        cout << "# Strategy selection: " << (use_bandit ? "ucb" : "exhaustive") << endl;
 
         for (int i = 1; i <= MAX_ITERATIONS; i++) {
             int conflicts = 0;
 
-            obtuse_triangles_before = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+            obtuse_triangles_before = obtuse_triangles_current;
             obtuse_triangles_after = 0;
 
             convergence_iterations++;
 
-            std::vector<CDT::Face_handle> finite_faces;
-
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                finite_faces.push_back(fit);
-            }
-
             //
             // Optimization algorithm
             //
 
             const unsigned int steiner_points_before_algorithm = steinerPoints.size();
 
-            for (auto fit : finite_faces) {
+            CDT::Face_handle fit;
+
+            while (!batch.full() && worklist.pop(cdt, fit)) {
                 Point a = fit->vertex(0)->point();
                 Point b = fit->vertex(1)->point();
                 Point c = fit->vertex(2)->point();
 
-                bool result = utils::is_obtuse(a, b, c);
+                bool result = T::is_obtuse(a, b, c);
 
                 cout << " - Iteration: " << i << " Checking triangle: " << a << "," << b << "," << c << ", obtuse:" << result << ", obtuse triangles: " << obtuse_triangles_before << endl;
 
@@ -81,14 +210,45 @@ public:
                     // ---------------------------------------------------------
                     map<steiner_stategies::Strategy, int> options;
 
-                    for (steiner_stategies::Strategy& strategy : strategies) {
-                        CDT cdt_copy = cdt;
-                        Graph graph_copy;
-                        graph_copy.cdt = &cdt_copy;
-                        graph_copy.boundaryPolygon = graph.boundaryPolygon;
+                    CandidateCache::FaceKey face_key = CandidateCache::key(fit);
+
+                    vector<steiner_stategies::Strategy> order = use_bandit ? bandit.order(strategies) : strategies;
+
+                    // Best evaluated copy so far, committed by swap if its strategy wins
+                    unique_ptr<CDT> trial;
+                    steiner_stategies::Strategy trial_strategy = steiner_stategies::Strategy::NONE;
+                    int trial_obtuse_triangles = 0;
+                    Point trial_point;
+                    bool trial_inserted = false;
+                    Vertex_handle trial_vertex;
+
+                    // Candidates are all generated here, on the live triangulation, then evaluated by the scheduler
+                    vector<Candidate> candidates;
+                    candidates.reserve(order.size());
+
+                    for (steiner_stategies::Strategy& strategy : order) {
+                        CandidateCache::Entry* cached = cache.lookup(face_key, strategy);
+
+                        if (cached != nullptr) {
+                            if (cached->outcome == CandidateCache::EVALUATED) {
+                                options[strategy] = obtuse_triangles_before + cached->obtuse_delta;
+                            }
+
+                            cout << "\t";
+                            steiner_stategies::printStrategy(strategy);
+                            cout << " - Cached " << ((cached->outcome == CandidateCache::EVALUATED) ? obtuse_triangles_before + cached->obtuse_delta : -1) << endl;
+
+                            if (use_bandit && cached->outcome == CandidateCache::EVALUATED && -cached->obtuse_delta >= BANDIT_EARLY_EXIT_REDUCTION) {
+                                break;
+                            }
+
+                            continue;
+                        }
+
+                        auto evaluation_start = std::chrono::steady_clock::now();
 
                         if (strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
-                            int i = utils::find_obtuse_angle(a, b, c);             // 0:a, 1:b, 2:c
+                            int i = T::find_obtuse_angle(a, b, c);             // 0:a, 1:b, 2:c
                             if (i == -1) {
                                 cout << "CRITICAL ERROR: find_obtuse_angle failed " << endl;
                                 exit(1);
@@ -102,33 +262,144 @@ public:
                             bool is_constraint = utils::checkConstraints(cdt, boundaryPolygon, p1, p2);
 
                             if (is_constraint) {
+                                utils::candidateFootprint(cdt, fit, nullptr, strategy, footprint);
+                                cache.store(face_key, strategy, CandidateCache::SKIPPED, 0, footprint);
+                                bandit.record(strategy, 0, std::chrono::duration<double>(std::chrono::steady_clock::now() - evaluation_start).count());
                                 continue;
                             }
                         }
 
-                        Point* s = steiner_stategies::generateSteinerPoint(graph_copy, a, b, c, strategy);
+                        Point* s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy, fit); // leaves cdt unchanged
 
-                        if (s != nullptr) {
-                            if (utils::is_steiner_point_valid(boundaryPolygon, *s)) {
-                                graph_copy.cdt->insertByStrategy(*s, strategy);
-                                steiner_stategies::removeConflictPoints(graph_copy, a, b, c, strategy);
-                            }
+                        if (s == nullptr) {
+                            cout << "\t";
+                            steiner_stategies::printStrategy(strategy);
+                            cout << " - Method failed    " << endl;
 
-                            delete s;
+                            utils::candidateFootprint(cdt, fit, nullptr, strategy, footprint);
+                            cache.store(face_key, strategy, CandidateCache::FAILED, 0, footprint);
 
-                            int copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt_copy, *(graph.boundaryPolygon)) ;
+                            bandit.record(strategy, 0, std::chrono::duration<double>(std::chrono::steady_clock::now() - evaluation_start).count());
+                            continue;
+                        }
+
+                        int bound = utils::obtuseReductionBound(cdt, fit, s, strategy, boundaryPolygon);
 
-                            options[strategy] = copy_obtuse_triangles_after;
+                        if (!can_improve(options, strategy, obtuse_triangles_before, bound)) { // prune before copying
+                            delete s;
+
+                            pruned_candidates++;
 
                             cout << "\t";
                             steiner_stategies::printStrategy(strategy);
-                            cout << " - Method succeeded " << copy_obtuse_triangles_after << endl;
-                        } else {
+                            cout << " - Pruned by bound  " << endl;
+                            continue;
+                        }
+
+                        candidates.emplace_back();
+
+                        Candidate& candidate = candidates.back();
+
+                        candidate.strategy = strategy;
+                        candidate.point = *s;
+                        candidate.inserted = utils::is_steiner_point_valid(boundaryPolygon, *s, cdt.domain_index);
+                        candidate.bound = bound;
+                        candidate.generation_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - evaluation_start).count();
+
+                        delete s;
+                    }
+
+                    TaskScheduler::Group group;
+                    Best best(candidates.size());
+
+                    for (const auto& [key, value] : options) { // only cached options so far
+                        best.seed(key, value);
+                    }
+
+                    std::atomic<size_t> early_exit(candidates.size()); // the first candidate, in order, known to exit early
+
+                    for (size_t k = 0; k < candidates.size(); k++) {
+                        // Pruned again against the candidates before it evaluated by then, skipped after an early exit
+                        scheduler.submit(group, [&, k](unsigned int) {
+                            Candidate& candidate = candidates[k];
+
+                            if (k > early_exit.load()) {
+                                return;
+                            }
+
+                            if (!best.can_improve(k, candidate.strategy, obtuse_triangles_before, candidate.bound)) {
+                                candidate.pruned = true;
+                                return;
+                            }
+
+                            evaluateTrial<T>(graph, a, b, c, candidate.point, candidate.strategy, candidate.inserted, true, candidate.result);
+
+                            if (!best.offer(k, candidate.strategy, candidate.result.obtuse_triangles)) {
+                                candidate.result.cdt.reset(); // cannot be the copy committed below
+                            }
+
+                            if (use_bandit && obtuse_triangles_before - candidate.result.obtuse_triangles >= BANDIT_EARLY_EXIT_REDUCTION) {
+                                size_t first = early_exit.load();
+
+                                while (k < first && !early_exit.compare_exchange_weak(first, k)) {
+                                }
+                            }
+                        });
+                    }
+
+                    scheduler.wait(group);
+
+                    //
+                    // In order, as a serial scan: the tasks may have evaluated candidates that
+                    // it would have pruned, or that follow its early exit; those are dropped
+                    //
+                    bool exited = false;
+
+                    for (Candidate& candidate : candidates) {
+                        steiner_stategies::Strategy strategy = candidate.strategy;
+
+                        if (exited) {
+                            break;
+                        }
+
+                        if (candidate.pruned || (candidate.result.evaluated && !can_improve(options, strategy, obtuse_triangles_before, candidate.bound))) {
+                            pruned_candidates++;
+
                             cout << "\t";
                             steiner_stategies::printStrategy(strategy);
-                            cout << " - Method failed    " << endl;
+                            cout << " - Pruned by bound  " << endl;
+                            continue;
+                        }
+
+                        if (!candidate.result.evaluated) { // skipped after an early exit
+                            continue;
+                        }
+
+                        utils::candidateFootprint(cdt, fit, &candidate.point, strategy, footprint);
+
+                        int copy_obtuse_triangles_after = candidate.result.obtuse_triangles;
+
+                        options[strategy] = copy_obtuse_triangles_after;
+
+                        // Keep the copy if it is the option selected below so far
+                        if (candidate.result.cdt != nullptr && (trial_strategy == steiner_stategies::Strategy::NONE || copy_obtuse_triangles_after < trial_obtuse_triangles || (copy_obtuse_triangles_after == trial_obtuse_triangles && strategy < trial_strategy))) {
+                            trial = std::move(candidate.result.cdt);
+                            trial_strategy = strategy;
+                            trial_obtuse_triangles = copy_obtuse_triangles_after;
+                            trial_point = candidate.point;
+                            trial_inserted = candidate.inserted;
+                            trial_vertex = candidate.result.vertex; // a handle into the kept copy
                         }
 
+                        cache.store(face_key, strategy, CandidateCache::EVALUATED, copy_obtuse_triangles_after - obtuse_triangles_before, footprint);
+
+                        bandit.record(strategy, obtuse_triangles_before - copy_obtuse_triangles_after, candidate.generation_seconds + candidate.result.seconds);
+
+                        cout << "\t";
+                        steiner_stategies::printStrategy(strategy);
+                        cout << " - Method succeeded " << copy_obtuse_triangles_after << endl;
+
+                        exited = use_bandit && obtuse_triangles_before - copy_obtuse_triangles_after >= BANDIT_EARLY_EXIT_REDUCTION;
                     }
                     // ---------------------------------------------------------
                     int min_value = std::numeric_limits<int>::max();
@@ -142,8 +413,60 @@ public:
                     }
 
                     if (strategy != steiner_stategies::Strategy::NONE) {                        
-                        if (min_value < obtuse_triangles_before) {
-                            Point* s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy);
+                        if (min_value < obtuse_triangles_before && strategy == trial_strategy) { // the evaluated copy won: swap it in
+                            cout << "*Best Strategy selected: " ;
+
+                            steiner_stategies::printStrategy(strategy);
+
+                            cout << endl;
+
+                            if (trial_inserted) {
+                                utils::candidateFootprint(cdt, fit, &trial_point, strategy, footprint);
+
+                                if (batch.admits(strategy, footprint)) {
+                                    batch.add(fit, trial_point, strategy, min_value - obtuse_triangles_before, footprint);
+                                    cout << "  Batched, " << batch.size() << " points pending" << endl;
+                                    continue;
+                                }
+
+                                if (!batch.empty()) { // the live triangulation must stay as the batch saw it
+                                    deferred.push_back(face_key);
+                                    cout << "  Deferred until the pending batch is committed" << endl;
+                                    continue;
+                                }
+
+                                cache.touch(footprint);
+
+                                const unsigned int vertices_before = cdt.number_of_vertices();
+                                const unsigned int depth = ExactCollapse::derived_depth(fit);
+
+                                cdt.swap(*trial);
+                                swapped_commits++;
+
+                                steinerPoints.emplace_back(trial_point);
+
+                                pn.push_back(utils::calculate_p(steinerPoints.size(), 1, obtuse_triangles_before, min_value));
+
+                                obtuse_triangles_current = min_value;
+
+                                if (cdt.number_of_vertices() <= vertices_before) { // vertices were removed: stored handles may dangle
+                                    collapse.commit(cdt, Vertex_handle(), depth);
+
+                                    cache.clear();
+                                    worklist.seed(cdt);
+                                } else {
+                                    collapse.commit(cdt, trial_vertex, depth);
+
+                                    worklist.rebind(cdt);
+                                    worklist.pushRegion(cdt, trial_vertex);
+                                }
+
+                                break;
+                            } else {
+                                cout << "Steiner point ignored  - outside the boundaries " << endl;
+                            }
+                        } else if (min_value < obtuse_triangles_before) { // the winner came from the cache: replay it
+                            Point* s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy, fit);
 
                             cout << "*Best Strategy selected: " ;
 
@@ -151,20 +474,55 @@ public:
 
                             cout << endl;
 
-                            if (utils::is_steiner_point_valid(boundaryPolygon, *s)) {
-                                graph.cdt->insertByStrategy(*s, strategy);
-                                steiner_stategies::removeConflictPoints(graph, a, b, c, strategy);
+                            if (utils::is_steiner_point_valid(boundaryPolygon, *s, cdt.domain_index)) {
+                                utils::candidateFootprint(cdt, fit, s, strategy, footprint);
+
+                                if (batch.admits(strategy, footprint)) {
+                                    batch.add(fit, *s, strategy, min_value - obtuse_triangles_before, footprint);
+                                    cout << "  Batched, " << batch.size() << " points pending" << endl;
+                                    delete s;
+                                    continue;
+                                }
+
+                                if (!batch.empty()) { // the live triangulation must stay as the batch saw it
+                                    deferred.push_back(face_key);
+                                    cout << "  Deferred until the pending batch is committed" << endl;
+                                    delete s;
+                                    continue;
+                                }
+
+                                cache.touch(footprint);
+
+                                const unsigned int vertices_before = cdt.number_of_vertices();
+                                const unsigned int depth = ExactCollapse::derived_depth(fit);
+
+                                Vertex_handle v = steiner_stategies::applySteinerPoint(graph, a, b, c, *s, strategy, fit);
 
                                 steinerPoints.emplace_back(*s);
 
                                 pn.push_back(utils::calculate_p(steinerPoints.size(), 1, obtuse_triangles_before, min_value));
+
+                                obtuse_triangles_current = min_value;
+
+                                if (cdt.number_of_vertices() <= vertices_before) { // vertices were removed: stored handles may dangle
+                                    collapse.commit(cdt, Vertex_handle(), depth);
+
+                                    cache.clear();
+                                    worklist.seed(cdt);
+                                } else {
+                                    collapse.commit(cdt, v, depth);
+
+                                    worklist.pushRegion(cdt, v);
+                                }
+
+                                delete s;
+
+                                break;
                             } else {
                                 cout << "Steiner point ignored  - outside the boundaries " << endl;
                             }
 
                             delete s;
-
-                            break;
                         } else {
                             cout << "*Best Strategy rejected: " ;
 
@@ -176,13 +534,34 @@ public:
                 }
             }
 
+            // Insert the batch and update the obtuse count once for all of its points
+            batch.commit(graph, [&](const CommitBatch::Entry& entry, Vertex_handle v, unsigned int depth) {
+                cache.touch(entry.footprint);
+
+                steinerPoints.emplace_back(entry.point);
+
+                pn.push_back(utils::calculate_p(steinerPoints.size(), 1, obtuse_triangles_current, obtuse_triangles_current + entry.obtuse_delta));
+
+                obtuse_triangles_current += entry.obtuse_delta;
+
+                collapse.commit(cdt, v, depth);
+
+                worklist.pushRegion(cdt, v);
+            });
+
+            for (const CandidateCache::FaceKey& key : deferred) {
+                worklist.requeue(cdt, key);
+            }
+
+            deferred.clear();
+
             const unsigned int steiner_points_after_algorithm = steinerPoints.size();
 
             if (steiner_points_after_algorithm == steiner_points_before_algorithm) {
                 local_minimum_reached = true;
             }
 
-            obtuse_triangles_after = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+            obtuse_triangles_after = obtuse_triangles_current;
 
             cout << " ### Initial: " << obtuse_triangles_initial << ", before: " << obtuse_triangles_before << ", after: " << obtuse_triangles_before << endl;
             // if (obtuse_triangles_after >= obtuse_triangles_before || conflicts == 0 || obtuse_triangles_after == 0) {
@@ -197,6 +576,11 @@ public:
                     if (x < obtuse_triangles_after) {
                         obtuse_triangles_after = x;
                         local_minimum_reached = false;
+
+                        obtuse_triangles_current = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+
+                        cache.clear();
+                        worklist.seed(cdt);
                     }
                 } 
             }
@@ -215,6 +599,12 @@ public:
         cout << " - Local minimum reached     : " << local_minimum_reached << endl;
         cout << " - Iterations for convergence: " << convergence_iterations << " of " << MAX_ITERATIONS << endl;
         cout << " - Convergence rate metric   : " << p << endl;
+        cout << " - Pruned candidates         : " << pruned_candidates << endl;
+        cout << " - Commits by swap           : " << swapped_commits << " of " << steinerPoints.size() << endl;
+        batch.print();
+        cache.print();
+        bandit.print();
+        collapse.print();
         cout << "***********************************************************************" << endl;
 
         return steinerPoints;
@@ -22,6 +22,7 @@
 #include "JsonExporter.h"
 #include "JsonLoader.h"
 #include "graph_definitions.h"
+#include "search_traits.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
 
@@ -37,7 +38,7 @@ public:
         CDT& cdt = *(graph.cdt);
 
         int MAX_ITERATIONS = loader.getL();
-        int obtuse_triangles_initial = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+        int obtuse_triangles_initial = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
         int obtuse_triangles_before = 0;
         int obtuse_triangles_after = 0;
         int convergence_iterations = 0;
@@ -48,16 +49,14 @@ public:
         for (int i = 1; i <= MAX_ITERATIONS; i++) {
             int conflicts = 0;
 
-            obtuse_triangles_before = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+            obtuse_triangles_before = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
             obtuse_triangles_after = 0;
 
             convergence_iterations++;
 
-            std::vector<CDT::Face_handle> finite_faces;
+            std::vector<CDT::Face_handle> finite_faces = utils::domain_faces(cdt); // exterior faces are never refined
 
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                finite_faces.push_back(fit);
-            }
+            utils::traversal_order(finite_faces);
 
             //
             // Optimization algorithm
@@ -70,7 +69,7 @@ public:
                 Point b = fit->vertex(1)->point();
                 Point c = fit->vertex(2)->point();
 
-                bool result = utils::is_obtuse(a, b, c);
+                bool result = T::is_obtuse(a, b, c);
 
                 cout << " - Iteration: " << i << " Checking triangle: " << a << "," << b << "," << c << ", obtuse:" << result << ", obtuse triangles: " << obtuse_triangles_before << endl;
 
@@ -80,14 +79,15 @@ public:
                     // ---------------------------------------------------------
                     map<steiner_stategies::Strategy, int> options;
 
-                    for (steiner_stategies::Strategy& strategy : strategies) {
-                        CDT cdt_copy = cdt;
-                        Graph graph_copy;
-                        graph_copy.cdt = &cdt_copy;
-                        graph_copy.boundaryPolygon = graph.boundaryPolygon;
+                    // Best evaluated copy so far, committed by swap
+                    CDT trial;
+                    steiner_stategies::Strategy trial_strategy = steiner_stategies::Strategy::NONE;
+                    Point trial_point;
+                    bool trial_inserted = false;
 
+                    for (steiner_stategies::Strategy& strategy : strategies) {
                         if (strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
-                            int i = utils::find_obtuse_angle(a, b, c);             // 0:a, 1:b, 2:c
+                            int i = T::find_obtuse_angle(a, b, c);             // 0:a, 1:b, 2:c
                             if (i == -1) {
                                 cout << "CRITICAL ERROR: find_obtuse_angle failed " << endl;
                                 exit(1);
@@ -105,17 +105,31 @@ public:
                             }
                         }
 
-                        Point* s = steiner_stategies::generateSteinerPoint(graph_copy, a, b, c, strategy);
+                        Point* s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy, fit);
 
                         if (s != nullptr) {
-                            if (utils::is_steiner_point_valid(boundaryPolygon, *s)) {
-                                graph_copy.cdt->insertByStrategy(*s, strategy);
-                                steiner_stategies::removeConflictPoints(graph_copy, a, b, c, strategy);
+                            CDT cdt_copy = cdt; // only candidates that exist are applied to a copy
+                            Graph graph_copy;
+                            graph_copy.cdt = &cdt_copy;
+                            graph_copy.boundaryPolygon = graph.boundaryPolygon;
+
+                            bool inserted = utils::is_steiner_point_valid(boundaryPolygon, *s, cdt.domain_index);
+
+                            if (inserted) {
+                                steiner_stategies::applySteinerPoint(graph_copy, a, b, c, *s, strategy);
                             }
 
-                            delete s;
+                            int copy_obtuse_triangles_after = T::countObtuseTriangles(cdt_copy, *(graph.boundaryPolygon)) ;
 
-                            int copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt_copy, *(graph.boundaryPolygon)) ;
+                            // Keep the copy if it is the option selected below so far
+                            if (trial_strategy == steiner_stategies::Strategy::NONE || copy_obtuse_triangles_after < options[trial_strategy] || (copy_obtuse_triangles_after == options[trial_strategy] && strategy < trial_strategy)) {
+                                trial.swap(cdt_copy);
+                                trial_strategy = strategy;
+                                trial_point = *s;
+                                trial_inserted = inserted;
+                            }
+
+                            delete s;
 
                             options[strategy] = copy_obtuse_triangles_after;
 
@@ -141,28 +155,23 @@ public:
                     }
 
                     if (strategy != steiner_stategies::Strategy::NONE) {                        
-                        if (min_value < obtuse_triangles_before) {
-                            Point* s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy);
-
+                        if (min_value < obtuse_triangles_before) { // strategy == trial_strategy: swap the evaluated copy in
                             cout << "*Best Strategy selected: " ;
 
                             steiner_stategies::printStrategy(strategy);
 
                             cout << endl;
 
-                            if (utils::is_steiner_point_valid(boundaryPolygon, *s)) {
-                                graph.cdt->insertByStrategy(*s, strategy);
-                                steiner_stategies::removeConflictPoints(graph, a, b, c, strategy);
+                            if (trial_inserted) {
+                                cdt.swap(trial);
 
-                                steinerPoints.emplace_back(*s);
+                                steinerPoints.emplace_back(trial_point);
 
                                 pn.push_back(utils::calculate_p(steinerPoints.size(), 1, obtuse_triangles_before, min_value));
                             } else {
                                 cout << "Steiner point ignored  - outside the boundaries " << endl;
                             }
 
-                            delete s;
-
                             break;
                         } else {
                             cout << "*Best Strategy rejected: " ;
@@ -181,7 +190,7 @@ public:
                 local_minimum_reached = true;
             }
 
-            obtuse_triangles_after = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+            obtuse_triangles_after = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
 
             cout << " ### Initial: " << obtuse_triangles_initial << ", before: " << obtuse_triangles_before << ", after: " << obtuse_triangles_before << endl;
             // if (obtuse_triangles_after >= obtuse_triangles_before || conflicts == 0 || obtuse_triangles_after == 0) {
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Macros and headers for CGAL
+#include <CGAL/number_utils.h>
+
+using namespace std;
+
+//
+// Jump-and-walk point location for a triangulation. The bounding box of the
+// vertices is cut into a uniform grid holding one vertex per cell, so a query
+// jumps to a vertex near the point and the walk starts from one of its faces
+// instead of crossing the whole triangulation. The grid only chooses where
+// walks start: a cell that lost its vertex, or a vertex added behind the
+// grid's back, costs a longer walk but never a wrong answer.
+//
+// Vertex_handle is the handle type of the triangulation (the grid stores
+// handles, so it must never outlive or follow a copy of the triangulation).
+//
+template <class Vertex_handle>
+class LocateGrid {
+public:
+    // Grid cells per vertex at the time of a rebuild
+    static constexpr double CELLS_PER_VERTEX = 0.25;
+
+    // Rings of cells searched around an empty cell before giving up
+    static constexpr int SEARCH_RINGS = 2;
+
+    bool built() const {
+        return columns > 0;
+    }
+
+    // Vertices the grid was sized for
+    size_t size() const {
+        return vertices;
+    }
+
+    void clear() {
+        columns = rows = 0;
+        vertices = 0;
+        cells.clear();
+    }
+
+    // Sizes the grid for the n vertices in [begin, end) and records them
+    template <class VertexIterator>
+    void rebuild(VertexIterator begin, VertexIterator end, size_t n) {
+        clear();
+
+        if (n == 0) {
+            return;
+        }
+
+        min_x = min_y = std::numeric_limits<double>::infinity();
+        max_x = max_y = -std::numeric_limits<double>::infinity();
+
+        for (VertexIterator v = begin; v != end; ++v) {
+            double x = CGAL::to_double(v->point().x());
+            double y = CGAL::to_double(v->point().y());
+
+            min_x = std::min(min_x, x);
+            max_x = std::max(max_x, x);
+            min_y = std::min(min_y, y);
+            max_y = std::max(max_y, y);
+        }
+
+        double width = std::max(max_x - min_x, 1e-9);
+        double height = std::max(max_y - min_y, 1e-9);
+        double cells_wanted = std::max(1.0, CELLS_PER_VERTEX * n);
+
+        // Roughly square cells
+        columns = std::max(1, (int)std::ceil(std::sqrt(cells_wanted * width / height)));
+        rows = std::max(1, (int)std::ceil(cells_wanted / columns));
+
+        cell_width = width / columns;
+        cell_height = height / rows;
+
+        cells.assign((size_t)columns * rows, Vertex_handle());
+        vertices = n;
+
+        for (VertexIterator v = begin; v != end; ++v) {
+            insert(v);
+        }
+    }
+
+    // v becomes the representative of its cell
+    void insert(Vertex_handle v) {
+        if (built()) {
+            cells[cell_of(v->point())] = v;
+        }
+    }
+
+    // Must be called before v is destroyed
+    void remove(Vertex_handle v) {
+        if (!built()) {
+            return;
+        }
+
+        size_t cell = cell_of(v->point());
+
+        if (cells[cell] == v) {
+            cells[cell] = Vertex_handle();
+        }
+    }
+
+    // A vertex in the cell of p or in the nearest non-empty ring around it,
+    // or a null handle
+    template <class Point>
+    Vertex_handle nearest(const Point& p) const {
+        if (!built()) {
+            return Vertex_handle();
+        }
+
+        int column = column_of(CGAL::to_double(p.x()));
+        int row = row_of(CGAL::to_double(p.y()));
+
+        for (int ring = 0; ring <= SEARCH_RINGS; ring++) {
+            for (int r = std::max(0, row - ring); r <= std::min(rows - 1, row + ring); r++) {
+                for (int c = std::max(0, column - ring); c <= std::min(columns - 1, column + ring); c++) {
+                    if (std::max(std::abs(r - row), std::abs(c - column)) != ring) { // inner rings were searched already
+                        continue;
+                    }
+
+                    Vertex_handle v = cells[(size_t)r * columns + c];
+
+                    if (v != Vertex_handle()) {
+                        return v;
+                    }
+                }
+            }
+        }
+
+        return Vertex_handle();
+    }
+
+private:
+    double min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+    double cell_width = 0, cell_height = 0;
+    int columns = 0, rows = 0;
+    size_t vertices = 0;
+
+    vector<Vertex_handle> cells; // row major
+
+    // Clamped before the conversion, so far-away points land in a border cell
+    static int clamp(double i, int n) {
+        return (i >= 0) ? (int)std::min(std::floor(i), n - 1.0) : 0;
+    }
+
+    int column_of(double x) const {
+        return clamp((x - min_x) / cell_width, columns);
+    }
+
+    int row_of(double y) const {
+        return clamp((y - min_y) / cell_height, rows);
+    }
+
+    template <class Point>
+    size_t cell_of(const Point& p) const {
+        return (size_t)row_of(CGAL::to_double(p.y())) * columns + column_of(CGAL::to_double(p.x()));
+    }
+};
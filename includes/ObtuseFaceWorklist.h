@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <vector>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+
+// Configuration
+#include "triangulation_configuration.h"
+
+// Support classes
+#include "CandidateCache.h"
+#include "FaceSnapshot.h"
+#include "utils.hpp"
+
+using namespace std;
+
+//
+// Worklist of obtuse faces still to be examined, worst face first (see
+// utils::obtuse_severity). Faces are stored by their vertices, so entries
+// survive the face being re-created with the same vertices and silently
+// disappear when the face is destroyed. Re-queuing a face gives it a new
+// stamp; older heap entries for it become stale and are skipped on pop.
+// After a commit only the faces around the new vertex are queued again.
+//
+// Keys hold vertex indices (VertexInfo::index); call rebind after the live
+// triangulation is swapped with an evaluated copy, whose handles differ.
+//
+class ObtuseFaceWorklist {
+public:
+    typedef CandidateCache::FaceKey FaceKey;
+
+    void seed(CDT& cdt) {
+        queue = priority_queue<Item>();
+        stamps.clear();
+
+        utils::index_vertices(cdt, handles);
+
+        FaceSnapshot snapshot(cdt);
+
+        snapshot.classify();
+
+        for (CDT::Face_handle face : snapshot.obtuseFaces()) {
+            push(cdt, face);
+        }
+    }
+
+    void push(CDT& cdt, CDT::Face_handle face) {
+        if (!utils::in_domain(cdt, face)) {
+            return;
+        }
+
+        double severity = utils::obtuse_severity(cdt, face);
+
+        if (severity == 0) { // not obtuse
+            return;
+        }
+
+        FaceKey key = CandidateCache::key(face);
+
+        for (int i = 0; i < 3; i++) {
+            handles[face->vertex(i)->info().index] = face->vertex(i);
+        }
+
+        unsigned int stamp = ++last_stamp;
+
+        stamps[key] = stamp;
+
+        queue.push(Item{severity, stamp, key});
+    }
+
+    // Queues the faces incident to v and the faces across their outer edges
+    void pushRegion(CDT& cdt, Vertex_handle v) {
+        CDT::Face_circulator fc = cdt.incident_faces(v), done(fc);
+
+        if (fc == nullptr) {
+            return;
+        }
+
+        do {
+            if (!cdt.is_infinite(fc)) {
+                push(cdt, fc);
+            }
+
+            CDT::Face_handle outer = fc->neighbor(fc->index(v));
+
+            if (!cdt.is_infinite(outer)) {
+                push(cdt, outer);
+            }
+        } while (++fc != done);
+    }
+
+    // Queues the face with these vertices again, if it still exists
+    void requeue(CDT& cdt, const FaceKey& key) {
+        CDT::Face_handle face;
+
+        if (utils::find_face(cdt, handles, key, face)) {
+            push(cdt, face);
+        }
+    }
+
+    bool pop(CDT& cdt, CDT::Face_handle& face) {
+        while (!queue.empty()) {
+            Item item = queue.top();
+
+            queue.pop();
+
+            auto it = stamps.find(item.key);
+
+            if (it == stamps.end() || it->second != item.stamp) { // stale entry
+                continue;
+            }
+
+            stamps.erase(it);
+
+            if (utils::find_face(cdt, handles, item.key, face)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Re-resolves the queued keys against cdt after it was swapped with a copy
+    void rebind(CDT& cdt) {
+        utils::index_vertices(cdt, handles);
+    }
+
+    bool empty() const {
+        return stamps.empty();
+    }
+
+    size_t size() const {
+        return stamps.size();
+    }
+
+    // Obtuse faces of cdt, worst first, for engines that sweep a snapshot. With
+    // SPATIAL_FACE_ORDER they follow a Hilbert curve instead, for locality.
+    static vector<CDT::Face_handle> ordered(CDT& cdt) {
+        vector<std::pair<double, CDT::Face_handle>> scored;
+
+        FaceSnapshot snapshot(cdt);
+
+        snapshot.classify();
+
+        if (SPATIAL_FACE_ORDER) {
+            vector<CDT::Face_handle> faces = snapshot.obtuseFaces();
+
+            utils::spatial_order(faces);
+
+            return faces;
+        }
+
+        for (CDT::Face_handle face : snapshot.obtuseFaces()) {
+            scored.emplace_back(utils::obtuse_severity(cdt, face), face);
+        }
+
+        std::stable_sort(scored.begin(), scored.end(), [](const auto& x, const auto& y) { return x.first > y.first; });
+
+        vector<CDT::Face_handle> faces;
+
+        for (auto& [severity, face] : scored) {
+            faces.push_back(face);
+        }
+
+        return faces;
+    }
+
+private:
+    struct Item {
+        double severity;
+        unsigned int stamp;
+        FaceKey key;
+
+        bool operator<(const Item& other) const {
+            return severity < other.severity;
+        }
+    };
+
+    priority_queue<Item> queue;
+    map<FaceKey, unsigned int> stamps; // current stamp of every queued face
+    utils::VertexHandles handles;
+    unsigned int last_stamp = 0;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+// Standard C++
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <utility>
+#include <vector>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+#include <CGAL/spatial_sort.h>
+
+// Configuration
+#include "triangulation_configuration.h"
+
+// Support classes
+#include "JsonLoader.h"
+#include "graph_definitions.h"
+#include "search_traits.h"
+#include "steiner_strategies.h"
+#include "utils.hpp"
+
+// Namespaces
+using namespace std;
+
+//
+// Right-angle grid refinement for instances whose boundary and constraints
+// are axis-aligned (JsonLoader::isOrthogonal). The lines through the
+// coordinates of every input point cut the domain into rectangles, each of
+// which is a union of grid cells; the circumcircle of a cell holds no other
+// grid point, so the Delaunay triangulation of the grid points in the domain
+// cuts every cell into two right triangles and has no obtuse triangle at all.
+// The number of Steiner points is known before anything is inserted: the
+// grid points in the domain that are not input points.
+//
+// Every line is needed for that guarantee, so the grid grows with the square
+// of the distinct coordinates; beyond ORTHO_GRID_MAX_POINTS nodes no grid is
+// built at all. The domain test goes through the boundary's BoundaryIndex.
+//
+template <typename T>
+class OrthogonalMeshing {
+public:
+    // Grid points to insert, in spatial order; none when the grid is over the limit
+    vector<Point> gridPoints(JsonLoader& loader, const Polygon_2& boundaryPolygon, const BoundaryIndex* index) {
+        const vector<int>& points_x = loader.getPointsX();
+        const vector<int>& points_y = loader.getPointsY();
+
+        vector<int> xs(points_x.begin(), points_x.end());
+        vector<int> ys(points_y.begin(), points_y.end());
+
+        std::sort(xs.begin(), xs.end());
+        xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+
+        std::sort(ys.begin(), ys.end());
+        ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+        vector<Point> points;
+
+        if ((unsigned long long)xs.size() * ys.size() > ORTHO_GRID_MAX_POINTS) {
+            cout << "# Orthogonal grid: " << xs.size() << " x " << ys.size() << " lines, over the limit of " << ORTHO_GRID_MAX_POINTS << " nodes: skipped" << endl;
+            return points;
+        }
+
+        std::set<std::pair<int, int>> inputs;
+
+        for (size_t i = 0; i < points_x.size(); i++) {
+            inputs.emplace(points_x[i], points_y[i]);
+        }
+
+        for (int x : xs) {
+            for (int y : ys) {
+                if (inputs.count({x, y}) > 0) {
+                    continue;
+                }
+
+                Point p(x, y); // exact: input coordinates are ints
+
+                if (utils::is_steiner_point_valid(boundaryPolygon, p, index)) {
+                    points.push_back(p);
+                }
+            }
+        }
+
+        CGAL::spatial_sort(points.begin(), points.end(), K());
+
+        return points;
+    }
+
+    vector<Point> triangulate(Graph& graph, JsonLoader& loader) {
+        auto start = std::chrono::steady_clock::now();
+
+        CDT& cdt = *(graph.cdt);
+        vector<Point> steinerPoints;
+
+        int obtuse_triangles_initial = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+
+        vector<Point> points = gridPoints(loader, *(graph.boundaryPolygon), graph.cdt->domain_index);
+
+        cout << "# Orthogonal grid: " << points.size() << " Steiner points" << endl;
+
+        CDT::Face_handle hint;
+
+        for (const Point& p : points) {
+            Vertex_handle v = cdt.insertByStrategy(p, steiner_stategies::Strategy::POLYGON, hint); // with flips: Delaunay
+
+            hint = v->face();
+
+            steinerPoints.push_back(p);
+        }
+
+        int obtuse_triangles_after = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+
+        cout << "***********************************************************************" << endl;
+        cout << " - Initial obtuse triangles  : " << obtuse_triangles_initial << endl;
+        cout << " - Total obtuse triangles    : " << obtuse_triangles_after << endl;
+        cout << " - Total steiner points      : " << steinerPoints.size() << endl;
+        cout << " - Meshing time              : " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << endl;
+        cout << "***********************************************************************" << endl;
+
+        return steinerPoints;
+    }
+};
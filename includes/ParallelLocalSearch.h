@@ -0,0 +1,359 @@
+#pragma once
+
+// Standard C++
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <limits>
+#include <unordered_set>
+#include <vector>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+
+// Configuration
+#include "triangulation_configuration.h"
+
+// Support classes
+#include "CandidateCache.h"
+#include "CommitBatch.h"
+#include "ExactCollapse.h"
+#include "JsonLoader.h"
+#include "ObtuseFaceWorklist.h"
+#include "RandomizationMethod.h"
+#include "graph_definitions.h"
+#include "parallel_scan.h"
+#include "search_traits.h"
+#include "steiner_strategies.h"
+#include "utils.hpp"
+
+// Namespaces
+using namespace std;
+
+//
+// Local search in rounds. Each round picks a maximal independent set of
+// obtuse faces, worst first: a face is taken when none of the vertices
+// around its corners (the corners and their neighbours) was claimed by a face
+// taken before, i.e. the first colour class of a greedy colouring of the
+// graph joining faces whose neighbourhoods meet. Workers (parallel_scan) copy
+// the triangulation once per round and evaluate every strategy for their
+// faces on copies of that copy, as LocalSearch does with the exhaustive
+// selection. The winners are then committed together through a CommitBatch,
+// largest gain first; winners whose actual footprints still meet are left to
+// the next round. Winners that flip or remove points (POLYGON) are replayed
+// alone in rounds without any other winner.
+//
+// Worker threads copy the live triangulation concurrently, as the trials of
+// the other engines do (see evaluateTrial): the copies share its lazy Epeck
+// values, which is only safe with CGAL_HAS_THREADS; without it parallel_scan
+// runs a single worker.
+//
+template <typename T>
+class ParallelLocalSearch {
+private:
+    struct Result {
+        steiner_stategies::Strategy strategy = steiner_stategies::Strategy::NONE;
+        Point point;
+        int obtuse_triangles = std::numeric_limits<int>::max();
+        unsigned int evaluations = 0;
+        unsigned int pruned = 0;
+    };
+
+    // Faces of ordered (obtuse, worst first) whose corner neighbourhoods are pairwise disjoint
+    vector<CandidateCache::FaceKey> independentSet(CDT& cdt, const vector<CDT::Face_handle>& ordered) {
+        vector<CandidateCache::FaceKey> selected;
+        unordered_set<unsigned long> claimed;
+        vector<unsigned long> neighbourhood;
+
+        for (CDT::Face_handle face : ordered) {
+            neighbourhood.clear();
+
+            for (int k = 0; k < 3; k++) {
+                Vertex_handle v = face->vertex(k);
+
+                neighbourhood.push_back(v->info().index);
+
+                CDT::Vertex_circulator vc = cdt.incident_vertices(v), done(vc);
+
+                do {
+                    if (!cdt.is_infinite(vc)) {
+                        neighbourhood.push_back(vc->info().index);
+                    }
+                } while (++vc != done);
+            }
+
+            bool free = std::none_of(neighbourhood.begin(), neighbourhood.end(), [&](unsigned long index) { return claimed.count(index) > 0; });
+
+            if (free) {
+                claimed.insert(neighbourhood.begin(), neighbourhood.end());
+                selected.push_back(CandidateCache::key(face));
+            }
+        }
+
+        return selected;
+    }
+
+    // Best improving candidate for face of graph.cdt (a worker's copy); ties go to the lower strategy
+    Result evaluate(Graph& graph, CDT::Face_handle face, vector<steiner_stategies::Strategy>& strategies, int obtuse_triangles_before) {
+        CDT& cdt = *(graph.cdt);
+        const Polygon_2& boundaryPolygon = *(graph.boundaryPolygon);
+
+        Result best;
+
+        Point a = face->vertex(0)->point();
+        Point b = face->vertex(1)->point();
+        Point c = face->vertex(2)->point();
+
+        for (steiner_stategies::Strategy strategy : strategies) {
+            if (strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
+                int i = T::find_obtuse_angle(a, b, c);
+
+                if (i == -1) {
+                    continue;
+                }
+
+                std::tuple<int, int> edge_indices = utils::findOppositeEdge(i);
+
+                Point& p1 = face->vertex(std::get<0>(edge_indices))->point();
+                Point& p2 = face->vertex(std::get<1>(edge_indices))->point();
+
+                if (utils::checkConstraints(cdt, boundaryPolygon, p1, p2)) {
+                    continue;
+                }
+            }
+
+            Point* s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy, face);
+
+            if (s == nullptr) {
+                continue;
+            }
+
+            int bound = utils::obtuseReductionBound(cdt, face, s, strategy, boundaryPolygon);
+
+            if (bound <= 0 || (bound != std::numeric_limits<int>::max() && (obtuse_triangles_before - bound > best.obtuse_triangles || (obtuse_triangles_before - bound == best.obtuse_triangles && strategy > best.strategy)))) {
+                best.pruned++;
+                delete s;
+                continue;
+            }
+
+            if (utils::is_steiner_point_valid(boundaryPolygon, *s, cdt.domain_index)) {
+                CDT trial = cdt;
+                Graph graph_trial;
+                graph_trial.cdt = &trial;
+                graph_trial.boundaryPolygon = graph.boundaryPolygon;
+
+                steiner_stategies::applySteinerPoint(graph_trial, a, b, c, *s, strategy);
+
+                int obtuse_triangles = T::countObtuseTriangles(trial, boundaryPolygon);
+
+                best.evaluations++;
+
+                if (obtuse_triangles < best.obtuse_triangles || (obtuse_triangles == best.obtuse_triangles && strategy < best.strategy)) {
+                    best.strategy = strategy;
+                    best.point = *s;
+                    best.obtuse_triangles = obtuse_triangles;
+                }
+            }
+
+            delete s;
+        }
+
+        if (best.obtuse_triangles >= obtuse_triangles_before) { // no improvement
+            best.strategy = steiner_stategies::Strategy::NONE;
+        }
+
+        return best;
+    }
+
+public:
+    vector<Point> triangulate(vector<steiner_stategies::Strategy>& strategies, Graph& graph, JsonLoader& loader, Polygon& boundaryPolygon) {
+        vector<Point> steinerPoints;
+        vector<double> pn;
+        CDT& cdt = *(graph.cdt);
+
+        int MAX_ITERATIONS = loader.getL();
+        int obtuse_triangles_initial = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+        int obtuse_triangles_current = obtuse_triangles_initial;
+        int convergence_iterations = 0;
+        bool local_minimum_reached = false;
+
+        ExactCollapse collapse;
+        CommitBatch batch(std::numeric_limits<size_t>::max());
+        vector<Vertex_handle> footprint;
+
+        unsigned long selected_faces = 0;
+        unsigned long evaluations = 0;
+        unsigned long pruned_candidates = 0;
+        unsigned long deferred_winners = 0;
+        unsigned long replayed_winners = 0;
+
+        cout << "# Max iterations: " << MAX_ITERATIONS << endl;
+        cout << "# Worker threads: " << parallel_scan::threads() << endl;
+
+        for (int i = 1; i <= MAX_ITERATIONS && obtuse_triangles_current > 0; i++) {
+            convergence_iterations++;
+
+            const int obtuse_triangles_before = obtuse_triangles_current;
+            const unsigned int steiner_points_before = steinerPoints.size();
+
+            vector<CDT::Face_handle> obtuse_faces = ObtuseFaceWorklist::ordered(cdt);
+            vector<CandidateCache::FaceKey> selected = independentSet(cdt, obtuse_faces);
+            vector<Result> results(selected.size());
+
+            selected_faces += selected.size();
+
+            //
+            // Evaluation: one copy of the triangulation per worker
+            //
+            unsigned int workers = std::max(1u, (unsigned int)std::min<size_t>(parallel_scan::threads(), selected.size()));
+            std::atomic<size_t> next(0);
+
+            parallel_scan::parallel_for(workers, 1, [&](size_t, size_t) {
+                CDT snapshot = cdt;
+                Graph graph_snapshot;
+                graph_snapshot.cdt = &snapshot;
+                graph_snapshot.boundaryPolygon = graph.boundaryPolygon;
+
+                utils::VertexHandles handles;
+                utils::index_vertices(snapshot, handles);
+
+                for (size_t k = next++; k < selected.size(); k = next++) {
+                    CDT::Face_handle face;
+
+                    if (utils::find_face(snapshot, handles, selected[k], face)) {
+                        results[k] = evaluate(graph_snapshot, face, strategies, obtuse_triangles_before);
+                    }
+                }
+            });
+
+            //
+            // Commit: largest gain first, disjoint footprints only
+            //
+            vector<size_t> winners;
+
+            for (size_t k = 0; k < results.size(); k++) {
+                evaluations += results[k].evaluations;
+                pruned_candidates += results[k].pruned;
+
+                if (results[k].strategy != steiner_stategies::Strategy::NONE) {
+                    winners.push_back(k);
+                }
+            }
+
+            std::stable_sort(winners.begin(), winners.end(), [&](size_t x, size_t y) { return results[x].obtuse_triangles < results[y].obtuse_triangles; });
+
+            utils::VertexHandles handles;
+            utils::index_vertices(cdt, handles);
+
+            size_t replay = results.size(); // best winner that must be committed alone
+
+            for (size_t k : winners) {
+                CDT::Face_handle face;
+
+                if (!utils::find_face(cdt, handles, selected[k], face)) {
+                    continue;
+                }
+
+                const Result& result = results[k];
+
+                if (result.strategy <= 0) {
+                    if (replay == results.size()) {
+                        replay = k;
+                    }
+
+                    continue;
+                }
+
+                utils::candidateFootprint(cdt, face, &result.point, result.strategy, footprint);
+
+                if (batch.admits(result.strategy, footprint)) {
+                    batch.add(face, result.point, result.strategy, result.obtuse_triangles - obtuse_triangles_before, footprint);
+                } else {
+                    deferred_winners++;
+                }
+            }
+
+            CDT::Face_handle face;
+
+            // The winner re-triangulates around its point: commit it on its own, unless its face is gone
+            if (batch.empty() && replay != results.size() && utils::find_face(cdt, handles, selected[replay], face)) {
+                const Result& result = results[replay];
+
+                Point a = face->vertex(0)->point();
+                Point b = face->vertex(1)->point();
+                Point c = face->vertex(2)->point();
+
+                const unsigned int vertices_before = cdt.number_of_vertices();
+                const unsigned int depth = ExactCollapse::derived_depth(face);
+
+                Vertex_handle v = steiner_stategies::applySteinerPoint(graph, a, b, c, result.point, result.strategy, face);
+
+                collapse.commit(cdt, (cdt.number_of_vertices() > vertices_before) ? v : Vertex_handle(), depth);
+
+                steinerPoints.emplace_back(result.point);
+
+                pn.push_back(utils::calculate_p(steinerPoints.size(), 1, obtuse_triangles_current, result.obtuse_triangles));
+
+                obtuse_triangles_current = result.obtuse_triangles;
+
+                replayed_winners++;
+            } else {
+                deferred_winners += (replay != results.size()) ? 1 : 0;
+            }
+
+            batch.commit(graph, [&](const CommitBatch::Entry& entry, Vertex_handle v, unsigned int depth) {
+                collapse.commit(cdt, v, depth);
+
+                steinerPoints.emplace_back(entry.point);
+
+                pn.push_back(utils::calculate_p(steinerPoints.size(), 1, obtuse_triangles_current, obtuse_triangles_current + entry.obtuse_delta));
+
+                obtuse_triangles_current += entry.obtuse_delta;
+            });
+
+            // The deltas were measured on snapshots and neighbouring winners interact:
+            // recount once per round so the loop condition and the report stay exact
+            if (steinerPoints.size() != steiner_points_before) {
+                obtuse_triangles_current = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+            }
+
+            cout << " - Round: " << i << " obtuse faces: " << obtuse_faces.size() << ", independent: " << selected.size() << ", winners: " << winners.size()
+                 << ", committed: " << steinerPoints.size() - steiner_points_before << ", obtuse triangles: " << obtuse_triangles_current << endl;
+
+            if (steinerPoints.size() == steiner_points_before) {
+                local_minimum_reached = true;
+
+                if (ENABLE_RANDOMIZATION_METHOD && obtuse_triangles_current > 0) {
+                    int x = RandomizationMethod<T>::tryMethod(cdt, boundaryPolygon, loader, pn, steinerPoints.size(), RANDOMIZATION_RETRIES);
+
+                    if (x < obtuse_triangles_current) {
+                        obtuse_triangles_current = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+                        local_minimum_reached = false;
+                    }
+                }
+
+                if (local_minimum_reached) {
+                    break;
+                }
+            }
+        }
+
+        double p = utils::average(pn);
+
+        cout << "***********************************************************************" << endl;
+        cout << " - Initial obtuse triangles  : " << obtuse_triangles_initial << endl;
+        cout << " - Total obtuse triangles    : " << obtuse_triangles_current << endl;
+        cout << " - Total steiner points      : " << steinerPoints.size() << endl;
+        cout << " - Local minimum reached     : " << local_minimum_reached << endl;
+        cout << " - Rounds for convergence    : " << convergence_iterations << " of " << MAX_ITERATIONS << endl;
+        cout << " - Convergence rate metric   : " << p << endl;
+        cout << " - Worker threads            : " << parallel_scan::threads() << endl;
+        cout << " - Independent faces         : " << selected_faces << " (" << evaluations << " evaluations, " << pruned_candidates << " pruned)" << endl;
+        cout << " - Winners left for later    : " << deferred_winners << " (" << replayed_winners << " committed alone)" << endl;
+        batch.print();
+        collapse.print();
+        cout << "***********************************************************************" << endl;
+
+        return steinerPoints;
+    }
+};
@@ -0,0 +1,331 @@
+#pragma once
+
+// Standard C++
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+#include <CGAL/spatial_sort.h>
+
+// Configuration
+#include "triangulation_configuration.h"
+
+// Support classes
+#include "BoundaryIndex.h"
+#include "JsonLoader.h"
+#include "graph_definitions.h"
+#include "search_traits.h"
+#include "steiner_strategies.h"
+#include "utils.hpp"
+
+// Namespaces
+using namespace std;
+
+//
+// Constructive meshing: a quadtree over the input points, split until every
+// leaf holds at most one point and then balanced (neighbouring leaves differ
+// by at most one level). The leaf corners are inserted as Steiner points:
+// squares, and squares with a hanging midpoint, triangulate into right and
+// acute triangles. A corner close to an input point is dropped in favour of
+// the point (the mesh is warped to it), and corners outside the boundary or
+// too close to it are clipped. Obtuse triangles can remain around input
+// points and along the boundary: -m quadtree exports the mesh as it is and
+// reports how many are left, -m qtls hands them to the local search.
+//
+// The root square has an integer corner and a power of two side, so every
+// corner is a dyadic rational that doubles represent exactly.
+//
+template <typename T>
+class QuadtreeMeshing {
+private:
+    typedef unsigned long long Key;
+
+    struct Node {
+        int depth;
+        long ix, iy;
+    };
+
+    double x0 = 0, y0 = 0, side = 1; // the root square
+    std::unordered_set<Key> internal; // split nodes, by key(depth, ix, iy)
+
+    unsigned long warped_corners = 0;
+    unsigned long clipped_corners = 0;
+
+    static Key key(int depth, long ix, long iy) {
+        return ((Key)depth << 58) | ((Key)ix << 29) | (Key)iy;
+    }
+
+    static Key corner(long X, long Y) {
+        return ((Key)X << 32) | (Key)Y;
+    }
+
+    bool is_internal(int depth, long ix, long iy) const {
+        return internal.count(key(depth, ix, iy)) > 0;
+    }
+
+    // Splits a node, and its ancestors first so that it exists; queues the new leaves
+    void split(int depth, long ix, long iy, vector<Node>& created) {
+        if (depth >= QUADTREE_MAX_DEPTH || is_internal(depth, ix, iy)) {
+            return;
+        }
+
+        if (depth > 0) {
+            split(depth - 1, ix / 2, iy / 2, created);
+        }
+
+        internal.insert(key(depth, ix, iy));
+
+        for (int c = 0; c < 4; c++) {
+            created.push_back(Node{depth + 1, 2 * ix + (c & 1), 2 * iy + (c >> 1)});
+        }
+    }
+
+    // Splits until every leaf holds at most one of the points
+    void subdivide(const Node& node, const vector<double>& xs, const vector<double>& ys, vector<int>& indices, vector<Node>& created) {
+        if (indices.size() <= 1 || node.depth >= QUADTREE_MAX_DEPTH) {
+            return;
+        }
+
+        split(node.depth, node.ix, node.iy, created);
+
+        double size = side / std::ldexp(1.0, node.depth + 1);
+        double mx = x0 + (2 * node.ix + 1) * size;
+        double my = y0 + (2 * node.iy + 1) * size;
+
+        vector<int> children[4];
+
+        for (int i : indices) {
+            children[(xs[i] >= mx ? 1 : 0) + (ys[i] >= my ? 2 : 0)].push_back(i);
+        }
+
+        for (int c = 0; c < 4; c++) {
+            subdivide(Node{node.depth + 1, 2 * node.ix + (c & 1), 2 * node.iy + (c >> 1)}, xs, ys, children[c], created);
+        }
+    }
+
+    // Splits the leaves next to much smaller ones until no two neighbours differ by more than one level
+    void balance(vector<Node> queue) {
+        while (!queue.empty()) {
+            Node leaf = queue.back();
+
+            queue.pop_back();
+
+            if (leaf.depth < 2 || is_internal(leaf.depth, leaf.ix, leaf.iy)) {
+                continue;
+            }
+
+            long n = 1L << leaf.depth;
+
+            for (int dx = -1; dx <= 1; dx++) {
+                for (int dy = -1; dy <= 1; dy++) {
+                    long nx = leaf.ix + dx;
+                    long ny = leaf.iy + dy;
+
+                    if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= n || ny >= n) {
+                        continue;
+                    }
+
+                    split(leaf.depth - 2, nx >> 2, ny >> 2, queue); // the neighbour's cell one level up must exist
+                }
+            }
+        }
+    }
+
+    vector<Node> leaves() const {
+        vector<Node> result;
+
+        if (internal.empty()) {
+            result.push_back(Node{0, 0, 0});
+            return result;
+        }
+
+        for (Key k : internal) {
+            int depth = (int)(k >> 58);
+            long ix = (long)((k >> 29) & ((1ULL << 29) - 1));
+            long iy = (long)(k & ((1ULL << 29) - 1));
+
+            for (int c = 0; c < 4; c++) {
+                if (!is_internal(depth + 1, 2 * ix + (c & 1), 2 * iy + (c >> 1))) {
+                    result.push_back(Node{depth + 1, 2 * ix + (c & 1), 2 * iy + (c >> 1)});
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // The leaf that contains (x, y)
+    Node locate(double x, double y) const {
+        Node node{0, 0, 0};
+
+        while (is_internal(node.depth, node.ix, node.iy)) {
+            double size = side / std::ldexp(1.0, node.depth + 1);
+
+            int c = (x >= x0 + (2 * node.ix + 1) * size ? 1 : 0) + (y >= y0 + (2 * node.iy + 1) * size ? 2 : 0);
+
+            node = Node{node.depth + 1, 2 * node.ix + (c & 1), 2 * node.iy + (c >> 1)};
+        }
+
+        return node;
+    }
+
+public:
+    vector<Point> triangulate(Graph& graph, JsonLoader& loader, Polygon& boundaryPolygon) {
+        auto start = std::chrono::steady_clock::now();
+
+        CDT& cdt = *(graph.cdt);
+        vector<Point> steinerPoints;
+
+        int obtuse_triangles_initial = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+
+        //
+        // Root square over the points and the boundary
+        //
+        vector<Point> points = loader.getPoints();
+        vector<double> xs, ys;
+
+        for (const Point& p : points) {
+            xs.push_back(CGAL::to_double(p.x()));
+            ys.push_back(CGAL::to_double(p.y()));
+        }
+
+        for (auto vit = boundaryPolygon.vertices_begin(); vit != boundaryPolygon.vertices_end(); ++vit) {
+            xs.push_back(CGAL::to_double(vit->x()));
+            ys.push_back(CGAL::to_double(vit->y()));
+        }
+
+        if (xs.empty()) {
+            return steinerPoints;
+        }
+
+        double x_min = *std::min_element(xs.begin(), xs.end()), x_max = *std::max_element(xs.begin(), xs.end());
+        double y_min = *std::min_element(ys.begin(), ys.end()), y_max = *std::max_element(ys.begin(), ys.end());
+
+        x0 = std::floor(x_min);
+        y0 = std::floor(y_min);
+        side = 1;
+
+        while (side < std::max(x_max - x0, y_max - y0)) {
+            side *= 2;
+        }
+
+        //
+        // Subdivide and balance
+        //
+        internal.clear();
+
+        vector<int> indices;
+
+        for (size_t i = 0; i < points.size(); i++) {
+            indices.push_back(i);
+        }
+
+        vector<Node> created;
+
+        subdivide(Node{0, 0, 0}, xs, ys, indices, created);
+
+        balance(leaves());
+
+        //
+        // Leaf corners, in units of the smallest possible cell, with the size of the smallest leaf at each
+        //
+        std::unordered_map<Key, double> corners;
+
+        for (const Node& leaf : leaves()) {
+            long scale = 1L << (QUADTREE_MAX_DEPTH - leaf.depth);
+            double size = side / std::ldexp(1.0, leaf.depth);
+
+            for (int c = 0; c < 4; c++) {
+                Key k = corner((leaf.ix + (c & 1)) * scale, (leaf.iy + (c >> 1)) * scale);
+
+                auto it = corners.find(k);
+
+                if (it == corners.end() || size < it->second) {
+                    corners[k] = size;
+                }
+            }
+        }
+
+        double unit = side / std::ldexp(1.0, QUADTREE_MAX_DEPTH);
+
+        // Warp: the input point replaces the nearest corner of its leaf when that is close
+        for (size_t i = 0; i < points.size(); i++) {
+            Node leaf = locate(xs[i], ys[i]);
+
+            double size = side / std::ldexp(1.0, leaf.depth);
+            long scale = 1L << (QUADTREE_MAX_DEPTH - leaf.depth);
+
+            long cx = leaf.ix + ((xs[i] - (x0 + leaf.ix * size) >= size / 2) ? 1 : 0);
+            long cy = leaf.iy + ((ys[i] - (y0 + leaf.iy * size) >= size / 2) ? 1 : 0);
+
+            double distance = std::hypot(xs[i] - (x0 + cx * size), ys[i] - (y0 + cy * size));
+
+            if (distance <= QUADTREE_WARP_DISTANCE * size && corners.erase(corner(cx * scale, cy * scale)) > 0) {
+                warped_corners++;
+            }
+        }
+
+        //
+        // Clip to the boundary, through the boundary grid, and insert along a Hilbert curve
+        //
+        const BoundaryIndex* index = cdt.domain_index;
+        unique_ptr<BoundaryIndex> local;
+
+        if (index == nullptr || !index->indexes(boundaryPolygon)) {
+            local.reset(new BoundaryIndex(boundaryPolygon));
+            index = local.get();
+        }
+
+        vector<Point> candidates;
+
+        for (const auto& [k, size] : corners) {
+            double x = x0 + (double)(k >> 32) * unit;
+            double y = y0 + (double)(k & 0xffffffffULL) * unit;
+
+            Point p(x, y);
+
+            if (index->bounded_side(p) == CGAL::ON_BOUNDED_SIDE && !index->near(p, QUADTREE_CLIP_DISTANCE * size)) {
+                candidates.push_back(p);
+            } else {
+                clipped_corners++;
+            }
+        }
+
+        CGAL::spatial_sort(candidates.begin(), candidates.end(), K());
+
+        CDT::Face_handle hint;
+
+        for (const Point& p : candidates) {
+            const unsigned int vertices_before = cdt.number_of_vertices();
+
+            Vertex_handle v = cdt.insertByStrategy(p, steiner_stategies::Strategy::POLYGON, hint); // with flips: Delaunay
+
+            hint = v->face();
+
+            if (cdt.number_of_vertices() > vertices_before) { // not an input point
+                steinerPoints.push_back(p);
+            }
+        }
+
+        int obtuse_triangles_after = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+
+        cout << "***********************************************************************" << endl;
+        cout << " - Initial obtuse triangles  : " << obtuse_triangles_initial << endl;
+        cout << " - Total obtuse triangles    : " << obtuse_triangles_after << endl;
+        cout << " - Total steiner points      : " << steinerPoints.size() << endl;
+        cout << " - Quadtree leaves           : " << leaves().size() << " (depth limit " << QUADTREE_MAX_DEPTH << ")" << endl;
+        cout << " - Corners warped / clipped  : " << warped_corners << " / " << clipped_corners << endl;
+        cout << " - Meshing time              : " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << endl;
+        cout << "***********************************************************************" << endl;
+
+        return steinerPoints;
+    }
+};
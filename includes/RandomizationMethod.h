@@ -22,6 +22,7 @@
 #include "JsonExporter.h"
 #include "JsonLoader.h"
 #include "graph_definitions.h"
+#include "search_traits.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
 #include "LocalSearchRandomization.h"
@@ -35,7 +36,7 @@ public:
     static int tryMethod(CDT& cdt, Polygon& boundaryPolygon, JsonLoader& loader, vector<double> & pn, int steiner_points_before, int MAX_ITERATIONS) {
         vector<Point> steinerPoints;
         
-        int obtuse_triangles_before = utils::countObtuseTriangles(cdt, boundaryPolygon);        
+        int obtuse_triangles_before = T::countObtuseTriangles(cdt, boundaryPolygon);        
 
         CDT cdt_copy = cdt;
         Graph graph_copy;
@@ -47,14 +48,14 @@ public:
             Point b = fit->vertex(1)->point();
             Point c = fit->vertex(2)->point();
 
-            bool result = utils::is_obtuse(a, b, c);
+            bool result = utils::in_domain(cdt, fit) && T::is_obtuse(a, b, c);
 
             if (result) {
                 Point* s = steiner_stategies::generateSteinerPoint(graph_copy, a, b, c, steiner_stategies::Strategy::RANDOM);
 
                 if (s != nullptr) {
-                    if (utils::is_steiner_point_valid(boundaryPolygon, *s)) {
-                        graph_copy.cdt->insertByStrategy(*s, steiner_stategies::Strategy::RANDOM);
+                    if (utils::is_steiner_point_valid(boundaryPolygon, *s, cdt.domain_index)) {
+                        steiner_stategies::applySteinerPoint(graph_copy, a, b, c, *s, steiner_stategies::Strategy::RANDOM);
 
                         MAX_ITERATIONS--;                        
                     }
@@ -76,14 +77,12 @@ public:
 
         int step = steinerPoints.size() - steiner_points_before;
 
-        int copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt_copy, boundaryPolygon) ;
+        int copy_obtuse_triangles_after = T::countObtuseTriangles(cdt_copy, boundaryPolygon) ;
 
         if (copy_obtuse_triangles_after < obtuse_triangles_before) {
             cout << "Local minimum break! " << endl;
 
-            for (Point & p : steinerPoints) {
-                cdt.insertByStrategy(p, steiner_stategies::Strategy::RANDOM); // flip???
-            }
+            cdt.swap(cdt_copy); // exactly the triangulation that was evaluated, random points included
 
 
             pn.push_back(utils::calculate_p(steinerPoints.size(), step, obtuse_triangles_before, obtuse_triangles_before));
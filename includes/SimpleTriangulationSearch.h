@@ -20,6 +20,7 @@
 #include "JsonExporter.h"
 #include "JsonLoader.h"
 #include "graph_definitions.h"
+#include "search_traits.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
 
@@ -40,37 +41,17 @@ public:
 
         cout << "# Max iterations: " << MAX_ITERATIONS << endl;
 
-        for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-            Point a = fit->vertex(0)->point();
-            Point b = fit->vertex(1)->point();
-            Point c = fit->vertex(2)->point();
-
-            if (utils::is_obtuse(a, b, c)) {
-                obtuse_triangles_initial++;
-            }
-        }
+        obtuse_triangles_initial = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
 
         for (int i = 1; i <= MAX_ITERATIONS; i++) {
             int conflicts = 0;
 
-            obtuse_triangles_before = 0;
+            obtuse_triangles_before = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
             obtuse_triangles_after = 0;
 
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                Point a = fit->vertex(0)->point();
-                Point b = fit->vertex(1)->point();
-                Point c = fit->vertex(2)->point();
-
-                if (utils::is_obtuse(a, b, c)) {
-                    obtuse_triangles_before++;
-                }
-            }
+            std::vector<CDT::Face_handle> finite_faces = utils::domain_faces(cdt); // exterior faces are never refined
 
-            std::vector<CDT::Face_handle> finite_faces;
-
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                finite_faces.push_back(fit);
-            }
+            utils::traversal_order(finite_faces);
 
             //
             // Optimization algorithm
@@ -81,7 +62,7 @@ public:
                 Point b = fit->vertex(1)->point();
                 Point c = fit->vertex(2)->point();
 
-                bool result = utils::is_obtuse(a, b, c);
+                bool result = T::is_obtuse(a, b, c);
 
                 cout << "Checking triangle: " << a << "," << b << "," << c << ", obtuse:" << result << endl;
 
@@ -89,7 +70,7 @@ public:
 
                 if (result) {
                     if (strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
-                        int i = utils::find_obtuse_angle(a, b, c);             // 0:a, 1:b, 2:c
+                        int i = T::find_obtuse_angle(a, b, c);             // 0:a, 1:b, 2:c
                         if (i == -1) {
                             cout << "CRITICAL ERROR: find_obtuse_angle failed " << endl;
                             exit(1);
@@ -107,12 +88,11 @@ public:
                         }
                     }
 
-                    Point* s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy);
+                    Point* s = steiner_stategies::generateSteinerPoint(graph, a, b, c, strategy, fit);
 
                     if (s != nullptr) {
-                        if (utils::is_steiner_point_valid(boundaryPolygon, *s)) {
-                            cdt.insertByStrategy(*s, strategy);
-                            steiner_stategies::removeConflictPoints(graph, a, b, c, strategy);
+                        if (utils::is_steiner_point_valid(boundaryPolygon, *s, cdt.domain_index)) {
+                            steiner_stategies::applySteinerPoint(graph, a, b, c, *s, strategy, fit);
                             
                             steinerPoints.emplace_back(*s);
                         }
@@ -122,15 +102,7 @@ public:
                 }
             }
 
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                Point a = fit->vertex(0)->point();
-                Point b = fit->vertex(1)->point();
-                Point c = fit->vertex(2)->point();
-
-                if (utils::is_obtuse(a, b, c)) {
-                    obtuse_triangles_after++;
-                }
-            }
+            obtuse_triangles_after = T::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
 
             cout << " ### Initial: " << obtuse_triangles_initial << ", before: " << obtuse_triangles_before << ", after: " << obtuse_triangles_before << endl;
             if (obtuse_triangles_after >= obtuse_triangles_before || conflicts == 0) {
@@ -2,6 +2,7 @@
 
 // Standard C++
 #include <cmath>
+#include <deque>
 #include <gmp.h>
 #include <iostream>
 #include <map>
@@ -20,10 +21,17 @@
 #include "triangulation_configuration.h"
 
 // Support classes
+#include "CandidateCache.h"
+#include "CommitBatch.h"
 #include "JsonExporter.h"
 #include "JsonLoader.h"
+#include "ExactCollapse.h"
+#include "ObtuseFaceWorklist.h"
 #include "RandomizationMethod.h"
 #include "graph_definitions.h"
+#include "search_traits.h"
+#include "TaskScheduler.h"
+#include "TrialEvaluation.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
 
@@ -41,6 +49,101 @@ private:
         return exp(-(e2 - e1) / T);
     }
 
+    // A face of the sweep, prepared on the live triangulation
+    struct Trial {
+        enum State { GONE, REGULAR, SKIPPED, PRUNED, FAILED, EVALUATE };
+
+        State state = GONE;
+        CDT::Face_handle face;
+        Point a, b, c;
+        bool obtuse = false;
+        steiner_stategies::Strategy strategy = steiner_stategies::Strategy::NONE;
+        Point point;
+        bool inserted = false;
+        float dice = -1; // drawn early when the bound already decides the acceptance test
+        TrialResult result;
+    };
+
+    // Draws the strategy and generates the candidate of a face; only the
+    // evaluation of the candidate is left to the scheduler
+    void prepare(const CandidateCache::FaceKey& key, utils::VertexHandles& handles, Trial& trial, vector<steiner_stategies::Strategy>& strategies, Graph& graph, Polygon& boundaryPolygon, float alpha, float beta, int obtuse_triangles_before, float E_current, size_t steiner_points, float T) {
+        CDT& cdt = *(graph.cdt);
+        CDT::Face_handle fit;
+
+        if (!utils::find_face(cdt, handles, key, fit)) { // destroyed by an earlier commit
+            trial.state = Trial::GONE;
+            return;
+        }
+
+        trial.face = fit;
+        trial.a = fit->vertex(0)->point();
+        trial.b = fit->vertex(1)->point();
+        trial.c = fit->vertex(2)->point();
+        trial.obtuse = U::is_obtuse(trial.a, trial.b, trial.c);
+        trial.state = Trial::REGULAR;
+
+        if (!trial.obtuse) {
+            return;
+        }
+
+        int n = strategies.size();
+        int N = rand() % n;
+
+        steiner_stategies::Strategy& selected_strategy = strategies[N];
+
+        trial.strategy = selected_strategy;
+
+        if (selected_strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
+            int i = U::find_obtuse_angle(trial.a, trial.b, trial.c);        // 0:a, 1:b, 2:c
+            if (i == -1) {
+                cout << "CRITICAL ERROR: find_obtuse_angle failed " << endl;
+                exit(1);
+            }
+
+            std::tuple<int, int> edge_indices = utils::findOppositeEdge(i); // a:1,2 b:0,2 c:0,1
+
+            Point& p1 = fit->vertex(std::get<0>(edge_indices))->point();
+            Point& p2 = fit->vertex(std::get<1>(edge_indices))->point();
+
+            bool is_constraint = utils::checkConstraints(cdt, boundaryPolygon, p1, p2);
+
+            if (is_constraint) {
+                trial.state = Trial::SKIPPED;
+                return;
+            }
+        }
+
+        Point* s = steiner_stategies::generateSteinerPoint(graph, trial.a, trial.b, trial.c, selected_strategy, fit); // leaves cdt unchanged
+
+        if (s == nullptr) {
+            trial.state = Trial::FAILED;
+            return;
+        }
+
+        if (selected_strategy != steiner_stategies::Strategy::POLYGON) { // POLYGON flips: unbounded
+            int bound = utils::obtuseReductionBound(cdt, fit, s, selected_strategy, boundaryPolygon);
+
+            float E_lowest = calculateEnergy(alpha, beta, obtuse_triangles_before - bound, steiner_points + 1);
+
+            if (E_lowest >= E_current) { // even the best case needs the dice
+                trial.dice = 0.01f * (rand() % 100);
+
+                if (!(trial.dice < calculateProbability(E_lowest, E_current, T))) {
+                    trial.state = Trial::PRUNED;
+
+                    delete s;
+                    return;
+                }
+            }
+        }
+
+        trial.point = *s;
+        trial.inserted = utils::is_steiner_point_valid(boundaryPolygon, *s, cdt.domain_index); // only candidates that exist are applied to a copy
+        trial.state = Trial::EVALUATE;
+
+        delete s;
+    }
+
 public:
     vector<Point> triangulate(vector<steiner_stategies::Strategy>& strategies, Graph& graph, JsonLoader& loader, Polygon& boundaryPolygon, float alpha, float beta) {
         vector<Point> steinerPoints;
@@ -48,7 +151,7 @@ public:
         CDT& cdt = *(graph.cdt);
 
         int MAX_ITERATIONS = loader.getL();
-        int obtuse_triangles_initial = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+        int obtuse_triangles_initial = U::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
         int obtuse_triangles_before = 0;
         int obtuse_triangles_after = 0;
         int convergence_iterations = 0;
@@ -56,6 +159,13 @@ public:
 
         float T = 1; // temperature
 
+        unsigned int pruned_candidates = 0;
+        ExactCollapse collapse;
+        CommitBatch batch(COMMIT_BATCH_SIZE);
+        vector<Vertex_handle> footprint;
+
+        TaskScheduler& scheduler = TaskScheduler::instance();
+
         cout << "# Max iterations: " << MAX_ITERATIONS << endl;
 
         float E = calculateEnergy(alpha, beta, obtuse_triangles_initial, steinerPoints.size());
@@ -66,7 +176,7 @@ public:
 
             int conflicts = 0;
 
-            obtuse_triangles_before = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+            obtuse_triangles_before = U::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
             obtuse_triangles_after = 0;
 
             convergence_iterations++;
@@ -74,127 +184,185 @@ public:
             float E_current = calculateEnergy(alpha, beta, obtuse_triangles_before, steinerPoints.size());
             float E_next = 0;
 
-            std::vector<CDT::Face_handle> finite_faces;
+            std::vector<CandidateCache::FaceKey> finite_faces; // worst faces first (see ordered), by vertex index so they survive commits
 
-            for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-                finite_faces.push_back(fit);
+            for (CDT::Face_handle face : ObtuseFaceWorklist::ordered(cdt)) {
+                finite_faces.push_back(CandidateCache::key(face));
             }
 
+            utils::VertexHandles handles;
+            utils::index_vertices(cdt, handles);
+
+            int obtuse_triangles_live = obtuse_triangles_before; // the batch's deltas are relative to this
+
+            auto commit_batch = [&]() {
+                batch.commit(graph, [&](const CommitBatch::Entry& entry, Vertex_handle v, unsigned int depth) {
+                    collapse.commit(cdt, v, depth);
+
+                    steinerPoints.emplace_back(entry.point);
+
+                    pn.push_back(utils::calculate_p(steinerPoints.size(), 1, obtuse_triangles_live, obtuse_triangles_live + entry.obtuse_delta));
+
+                    obtuse_triangles_live += entry.obtuse_delta;
+                });
+            };
+
             //
             // Optimization algorithm
             //
 
-            for (auto fit : finite_faces) {
-                Point a = fit->vertex(0)->point();
-                Point b = fit->vertex(1)->point();
-                Point c = fit->vertex(2)->point();
+            // Faces are prepared and evaluated a window at a time, one trial per
+            // worker, then decided in order. The whole window is prepared before
+            // any task starts, as preparing may touch the live triangulation. A
+            // decision that changes the live triangulation makes the rest of the
+            // window stale: those faces are prepared again, against the new
+            // triangulation.
+            size_t next = 0;
+
+            while (next < finite_faces.size()) {
+                std::deque<Trial> window; // stable references for the tasks
+                TaskScheduler::Group group;
+                unsigned int evaluations = 0;
+                size_t first = next;
 
-                bool result = utils::is_obtuse(a, b, c);
+                while (next < finite_faces.size() && evaluations < scheduler.workers()) {
+                    window.emplace_back();
 
-                cout << " - Iteration: " << i << " Temperature: " << T << ": Checking triangle: " << a << "," << b << "," << c << ", obtuse:" << result << ", obtuse triangles: " << obtuse_triangles_before << endl;
+                    Trial& trial = window.back();
 
-                conflicts++;
+                    prepare(finite_faces[next++], handles, trial, strategies, graph, boundaryPolygon, alpha, beta, obtuse_triangles_before, E_current, steinerPoints.size(), T);
 
-                if (result) {
-                    // ---------------------------------------------------------
-                    int n = strategies.size();
-                    int N = rand() % n;
+                    if (trial.state == Trial::EVALUATE) {
+                        evaluations++;
+                    }
+                }
 
-                    steiner_stategies::Strategy& selected_strategy = strategies[N];
+                for (Trial& trial : window) {
+                    if (trial.state == Trial::EVALUATE) {
+                        scheduler.submit(group, [&, entry = &trial](unsigned int) {
+                            evaluateTrial<U>(graph, entry->a, entry->b, entry->c, entry->point, entry->strategy, entry->inserted, true, entry->result);
+                        });
+                    }
+                }
 
-                    CDT cdt_copy = cdt;
-                    Graph graph_copy;
-                    graph_copy.cdt = &cdt_copy;
-                    graph_copy.boundaryPolygon = graph.boundaryPolygon;
+                scheduler.wait(group);
 
-                    if (selected_strategy == steiner_stategies::Strategy::PERICENTER) { // if max edge is constraint skip ...
-                        int i = utils::find_obtuse_angle(a, b, c);                      // 0:a, 1:b, 2:c
-                        if (i == -1) {
-                            cout << "CRITICAL ERROR: find_obtuse_angle failed " << endl;
-                            exit(1);
-                        }
+                for (size_t k = 0; k < window.size(); k++) {
+                    Trial& trial = window[k];
 
-                        std::tuple<int, int> edge_indices = utils::findOppositeEdge(i); // a:1,2 b:0,2 c:0,1
+                    if (trial.state == Trial::GONE) { // destroyed by an earlier commit
+                        continue;
+                    }
 
-                        Point& p1 = fit->vertex(std::get<0>(edge_indices))->point();
-                        Point& p2 = fit->vertex(std::get<1>(edge_indices))->point();
+                    cout << " - Iteration: " << i << " Temperature: " << T << ": Checking triangle: " << trial.a << "," << trial.b << "," << trial.c << ", obtuse:" << trial.obtuse << ", obtuse triangles: " << obtuse_triangles_before << endl;
 
-                        bool is_constraint = utils::checkConstraints(cdt, boundaryPolygon, p1, p2);
+                    conflicts++;
 
-                        if (is_constraint) {
-                            continue;
-                        }
+                    if (trial.state == Trial::PRUNED) {
+                        pruned_candidates++;
+
+                        cout << "\t";
+                        steiner_stategies::printStrategy(trial.strategy);
+                        cout << " - Pruned by bound  " << endl;
+                        continue;
+                    }
+
+                    if (trial.state == Trial::FAILED) {
+                        cout << "\t";
+                        steiner_stategies::printStrategy(trial.strategy);
+                        cout << " - New energy: " << E_current << " - Method failed    " << endl;
+                        continue;
                     }
 
-                    Point* s = steiner_stategies::generateSteinerPoint(graph_copy, a, b, c, selected_strategy);
+                    if (trial.state != Trial::EVALUATE) {
+                        continue;
+                    }
+
+                    steiner_stategies::Strategy selected_strategy = trial.strategy;
+                    Point* s = &trial.point;
+                    CDT::Face_handle fit = trial.face;
+                    float dice = trial.dice;
+
+                    int copy_obtuse_triangles_after = trial.result.obtuse_triangles;
+
+                    // The copy lacks the pending batch, whose points and changes add up with it
+                    E_next = calculateEnergy(alpha, beta, copy_obtuse_triangles_after + batch.obtuse_delta(), steinerPoints.size() + batch.size() + 1);
 
-                    E_next = E_current;
+                    cout << "\t";
+                    steiner_stategies::printStrategy(selected_strategy);
+                    cout << " - New energy: " << E_next << " - Method succeeded " << copy_obtuse_triangles_after << endl;
 
-                    if (s != nullptr) {
-                        if (utils::is_steiner_point_valid(boundaryPolygon, *s)) {
-                            cdt_copy.insertByStrategy(*s, selected_strategy);
-                            steiner_stategies::removeConflictPoints(graph_copy, a, b, c, selected_strategy);
+                    // --------------------------------------------------------- energy
+                    bool accept_strategy = false;
+
+                    if (E_next < E_current) {
+                        accept_strategy = true;
+                    } else {
+                        float prob = exp(-(E_next - E_current) / T);
+
+                        if (dice < 0) {
+                            dice = 0.01f * (rand() % 100);
                         }
 
-                        int copy_obtuse_triangles_after = utils::countObtuseTriangles(cdt_copy, *(graph.boundaryPolygon));
+                        if (dice < prob) {
+                            accept_strategy = true;
+                        }
+                    }
 
-                        E_next = calculateEnergy(alpha, beta, copy_obtuse_triangles_after, steinerPoints.size() + 1);
+                    if (accept_strategy) {
+                        cout << "* Energy: " << E_current << " to " << E_next << " - Strategy selected: ";
 
-                        cout << "\t";
                         steiner_stategies::printStrategy(selected_strategy);
-                        cout << " - New energy: " << E_next << " - Method succeeded " << copy_obtuse_triangles_after << endl;
 
-                        // --------------------------------------------------------- energy
-                        bool accept_strategy = false;
+                        cout << endl;
 
-                        if (E_next < E_current) {
-                            accept_strategy = true;
-                        } else {
-                            float prob = exp(-(E_next - E_current) / T);
-                            float dice = 0.01f * (rand() % 100);
+                        bool inserted = trial.inserted;
 
-                            if (dice < prob) {
-                                accept_strategy = true;
-                            }
+                        if (inserted && batch.enabled()) {
+                            utils::candidateFootprint(cdt, fit, s, selected_strategy, footprint);
                         }
 
-                        if (accept_strategy) {
-                            cout << "* Energy: " << E_current << " to " << E_next << " - Strategy selected: ";
+                        if (inserted && batch.admits(selected_strategy, footprint)) {
+                            batch.add(fit, *s, selected_strategy, copy_obtuse_triangles_after - obtuse_triangles_live, footprint);
 
-                            steiner_stategies::printStrategy(selected_strategy);
+                            if (batch.full()) {
+                                commit_batch();
 
-                            cout << endl;
+                                next = first + k + 1;
+                                break;
+                            }
+                        } else if (inserted && !batch.empty()) { // the live triangulation must stay as the batch saw it
+                            cout << "  Skipped until the next sweep: conflicts with the pending batch" << endl;
+                        } else if (inserted) { // the evaluated copy becomes the triangulation
+                            const unsigned int vertices_before = cdt.number_of_vertices();
+                            const unsigned int depth = ExactCollapse::derived_depth(fit);
 
-                            Point* s = steiner_stategies::generateSteinerPoint(graph_copy, a, b, c, selected_strategy);
+                            cdt.swap(*trial.result.cdt);
 
-                            if (s != nullptr && utils::is_steiner_point_valid(boundaryPolygon, *s)) {
-                                cdt.insertByStrategy(*s, selected_strategy);
-                                steiner_stategies::removeConflictPoints(graph, a, b, c, selected_strategy);
+                            collapse.commit(cdt, (cdt.number_of_vertices() > vertices_before) ? trial.result.vertex : Vertex_handle(), depth);
 
-                                steinerPoints.emplace_back(*s);
+                            utils::index_vertices(cdt, handles);
 
-                                pn.push_back(utils::calculate_p(steinerPoints.size(), 1, obtuse_triangles_before, copy_obtuse_triangles_after));
-                            } else {
-                                // cout << "Steiner point ignored  - outside the boundaries " << endl;
-                            }
+                            steinerPoints.emplace_back(*s);
 
-                            delete s;
-                        } else {
-                            cout << "* Energy: " << E_current << " to " << E_next << " - Strategy rejetced. " << endl;
+                            pn.push_back(utils::calculate_p(steinerPoints.size(), 1, obtuse_triangles_before, copy_obtuse_triangles_after));
 
-                            if (s != nullptr) {
-                                delete s;
-                            }
+                            obtuse_triangles_live = copy_obtuse_triangles_after;
+
+                            next = first + k + 1;
+                            break;
+                        } else {
+                            // cout << "Steiner point ignored  - outside the boundaries " << endl;
                         }
                     } else {
-                        cout << "\t";
-                        steiner_stategies::printStrategy(selected_strategy);
-                        cout << " - New energy: " << E_next << " - Method failed    " << endl;
+                        cout << "* Energy: " << E_current << " to " << E_next << " - Strategy rejetced. " << endl;
                     }
                 }
             }
 
-            obtuse_triangles_after = utils::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
+            commit_batch();
+
+            obtuse_triangles_after = U::countObtuseTriangles(cdt, *(graph.boundaryPolygon));
 
             cout << " ### Temperature: " << T << " - Initial: " << obtuse_triangles_initial << ", before: " << obtuse_triangles_before << ", after: " << obtuse_triangles_before << endl;
             // if (obtuse_triangles_after >= obtuse_triangles_before || conflicts == 0 || obtuse_triangles_after == 0) {
@@ -234,6 +402,9 @@ public:
         cout << " - Alpha                     : " << alpha << endl;
         cout << " - Beta                      : " << beta << endl;
         cout << " - Convergence rate metric   : " << p << endl;
+        cout << " - Pruned candidates         : " << pruned_candidates << endl;
+        batch.print();
+        collapse.print();
         cout << "***********************************************************************" << endl;
 
         return steinerPoints;
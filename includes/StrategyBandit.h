@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <vector>
+
+// Support classes
+#include "steiner_strategies.h"
+
+using namespace std;
+
+//
+// UCB1 selector over Steiner strategies. Each arm tracks how often its
+// candidate improved the triangulation and how many obtuse triangles it
+// removed per second of evaluation; order() ranks the strategies by that
+// payoff plus the usual exploration bonus. Strategies never tried come first.
+//
+class StrategyBandit {
+public:
+    struct Arm {
+        unsigned int pulls = 0;
+        unsigned int successes = 0;
+        double reduction = 0; // total obtuse triangles removed
+        double seconds = 0;   // total evaluation time
+    };
+
+    void record(steiner_stategies::Strategy strategy, int obtuse_reduction, double seconds) {
+        Arm& arm = arms[strategy];
+
+        arm.pulls++;
+        arm.seconds += seconds;
+
+        if (obtuse_reduction > 0) {
+            arm.successes++;
+            arm.reduction += obtuse_reduction;
+        }
+
+        total_pulls++;
+    }
+
+    vector<steiner_stategies::Strategy> order(const vector<steiner_stategies::Strategy>& strategies) {
+        double best_payoff = 0;
+
+        for (steiner_stategies::Strategy strategy : strategies) {
+            best_payoff = std::max(best_payoff, payoff(arms[strategy]));
+        }
+
+        vector<std::pair<double, steiner_stategies::Strategy>> ranked;
+
+        for (steiner_stategies::Strategy strategy : strategies) {
+            const Arm& arm = arms[strategy];
+
+            double score;
+
+            if (arm.pulls == 0) {
+                score = std::numeric_limits<double>::infinity();
+            } else {
+                double exploitation = (best_payoff > 0) ? payoff(arm) / best_payoff : 0;
+                double exploration = std::sqrt(2.0 * std::log((double)total_pulls) / arm.pulls);
+
+                score = exploitation + exploration;
+            }
+
+            ranked.emplace_back(score, strategy);
+        }
+
+        std::stable_sort(ranked.begin(), ranked.end(), [](const auto& x, const auto& y) { return x.first > y.first; });
+
+        vector<steiner_stategies::Strategy> result;
+
+        for (auto& [score, strategy] : ranked) {
+            result.push_back(strategy);
+        }
+
+        return result;
+    }
+
+    void print() {
+        cout << " - Strategy statistics       : pulls, success rate, mean reduction, mean ms" << endl;
+
+        for (auto& [strategy, arm] : arms) {
+            if (arm.pulls == 0) {
+                continue;
+            }
+
+            cout << "     ";
+            steiner_stategies::printStrategy((steiner_stategies::Strategy)strategy);
+            cout << " : " << arm.pulls << ", " << (double)arm.successes / arm.pulls << ", " << arm.reduction / arm.pulls << ", " << 1000.0 * arm.seconds / arm.pulls << endl;
+        }
+    }
+
+private:
+    map<int, Arm> arms;
+    unsigned int total_pulls = 0;
+
+    static double payoff(const Arm& arm) {
+        if (arm.pulls == 0) {
+            return 0;
+        }
+
+        return (arm.reduction / arm.pulls) / std::max(arm.seconds / arm.pulls, 1e-9);
+    }
+};
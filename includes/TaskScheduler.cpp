@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// CGAL_HAS_THREADS
+#include <CGAL/config.h>
+
+#include "TaskScheduler.h"
+#include "parallel_scan.h"
+#include "triangulation_configuration.h"
+
+using namespace std;
+
+TaskScheduler::TaskScheduler(unsigned int threads) {
+    for (unsigned int i = 0; i <= threads; i++) {
+        deques.emplace_back(new Deque());
+    }
+
+    for (unsigned int i = 1; i <= threads; i++) {
+        this->threads.emplace_back([this, i]() { loop(i); });
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+
+    wake.notify_all();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void TaskScheduler::submit(Group& group, Task task, int affinity) {
+    unsigned int worker = (affinity >= 0) ? (unsigned int)affinity % workers() : next_worker++ % workers();
+
+    group.pending++;
+
+    {
+        lock_guard<std::mutex> lock(deques[worker]->mutex);
+        deques[worker]->items.push_back(Item{std::move(task), &group});
+    }
+
+    {
+        lock_guard<std::mutex> lock(sleep_mutex); // a worker between its check and its sleep sees the count
+        queued++;
+    }
+
+    wake.notify_one();
+}
+
+bool TaskScheduler::take(unsigned int worker, bool oldest_first, Item& item) {
+    size_t n = deques.size();
+
+    for (size_t k = 0; k < n; k++) {
+        Deque& deque = *deques[(worker + k) % n];
+
+        lock_guard<std::mutex> lock(deque.mutex);
+
+        if (deque.items.empty()) {
+            continue;
+        }
+
+        if (k == 0 && !oldest_first) { // own deque: newest first
+            item = std::move(deque.items.back());
+            deque.items.pop_back();
+        } else { // stolen (or worker 0): oldest first
+            item = std::move(deque.items.front());
+            deque.items.pop_front();
+        }
+
+        if (k > 0) {
+            stolen_tasks++;
+        }
+
+        queued--;
+
+        return true;
+    }
+
+    return false;
+}
+
+void TaskScheduler::run(unsigned int worker, Item& item) {
+    if (item.group->cancelled()) {
+        dropped_tasks++;
+    } else {
+        auto start = std::chrono::steady_clock::now();
+
+        item.task(worker);
+
+        busy_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        executed_tasks++;
+    }
+
+    item.group->pending--;
+}
+
+void TaskScheduler::loop(unsigned int worker) {
+    parallel_scan::in_worker() = true; // scans inside tasks run inline
+
+    while (true) {
+        Item item;
+
+        if (take(worker, false, item)) {
+            run(worker, item);
+            continue;
+        }
+
+        unique_lock<std::mutex> lock(sleep_mutex);
+
+        wake.wait(lock, [&]() { return stopping || queued > 0; });
+
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void TaskScheduler::wait(Group& group) {
+    auto start = std::chrono::steady_clock::now();
+
+    while (group.pending > 0) {
+        Item item;
+
+        if (take(0, true, item)) {
+            run(0, item);
+        } else { // the last tasks are running elsewhere
+            std::this_thread::yield();
+        }
+    }
+
+    wait_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+TaskScheduler& TaskScheduler::instance() {
+#if defined(CGAL_HAS_THREADS)
+    static TaskScheduler scheduler(TRIAL_SCHEDULER_THREADS);
+#else
+    static TaskScheduler scheduler(0); // lazy exact numbers are only thread safe with CGAL_HAS_THREADS
+#endif
+
+    return scheduler;
+}
+
+double TaskScheduler::utilization() const {
+    double available = (double)wait_nanoseconds * workers();
+
+    return (available > 0) ? std::min(1.0, busy_nanoseconds / available) : 0.0;
+}
+
+void TaskScheduler::print() const {
+    cout << "Trial scheduler: " << executed() << " tasks on " << workers() << " workers, " << stolen() << " stolen, " << dropped() << " cancelled, utilization " << 100 * utilization() << "%" << endl;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Configuration
+#include "triangulation_configuration.h"
+
+using namespace std;
+
+//
+// Work-stealing scheduler for candidate evaluations, whose costs differ by
+// orders of magnitude (a POLYGON trial walks and edits a whole region, a
+// CENTROID trial splits one face). Every worker owns a deque: it runs its own
+// tasks newest first and, once it runs dry, steals the oldest task of another
+// worker, so no static split of the work is needed.
+//
+// The thread that submits and waits for a group is worker 0 and runs tasks
+// while it waits, oldest first; with no pool threads a group therefore runs
+// inline, in submission order. A task is told which worker runs it, so it can
+// use per-worker state. Cancelling a group drops its tasks that have not
+// started yet.
+//
+class TaskScheduler {
+public:
+    typedef std::function<void(unsigned int worker)> Task;
+
+    // Tasks waited for together
+    class Group {
+    public:
+        void cancel() {
+            stopped.store(true);
+        }
+
+        bool cancelled() const {
+            return stopped.load();
+        }
+
+    private:
+        friend class TaskScheduler;
+
+        std::atomic<size_t> pending{0};
+        std::atomic<bool> stopped{false};
+    };
+
+    explicit TaskScheduler(unsigned int threads);
+
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Pool threads plus the waiting thread
+    unsigned int workers() const {
+        return (unsigned int)deques.size();
+    }
+
+    // affinity: the worker whose deque takes the task, or -1 for round robin
+    void submit(Group& group, Task task, int affinity = -1);
+
+    // Runs tasks until every task of group has run or was dropped. Only the
+    // thread acting as worker 0 may wait, and never from inside a task.
+    void wait(Group& group);
+
+    // The engines' scheduler, with TRIAL_SCHEDULER_THREADS pool threads
+    static TaskScheduler& instance();
+
+    unsigned long executed() const {
+        return executed_tasks;
+    }
+
+    unsigned long stolen() const {
+        return stolen_tasks;
+    }
+
+    unsigned long dropped() const {
+        return dropped_tasks;
+    }
+
+    // Share of the workers' time spent in tasks while a group was awaited
+    double utilization() const;
+
+    void print() const;
+
+private:
+    struct Item {
+        Task task;
+        Group* group;
+    };
+
+    struct Deque {
+        std::mutex mutex;
+        std::deque<Item> items;
+    };
+
+    vector<unique_ptr<Deque>> deques; // one per worker, worker 0 first
+    vector<std::thread> threads;
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<unsigned int> next_worker{0};
+
+    std::atomic<unsigned long> executed_tasks{0};
+    std::atomic<unsigned long> stolen_tasks{0};
+    std::atomic<unsigned long> dropped_tasks{0};
+    std::atomic<unsigned long long> busy_nanoseconds{0};
+    std::atomic<unsigned long long> wait_nanoseconds{0};
+
+    bool take(unsigned int worker, bool oldest_first, Item& item);
+
+    void run(unsigned int worker, Item& item);
+
+    void loop(unsigned int worker);
+};
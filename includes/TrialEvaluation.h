@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+
+// Support classes
+#include "graph_definitions.h"
+#include "steiner_strategies.h"
+
+using namespace std;
+
+//
+// Outcome of inserting a candidate into a copy of a triangulation
+//
+struct TrialResult {
+    bool evaluated = false; // false when the task was cancelled or pruned
+    int obtuse_triangles = 0;
+    unique_ptr<CDT> cdt;  // the evaluated copy, when kept for a commit by swap
+    Vertex_handle vertex; // the new vertex, in cdt
+    double seconds = 0;
+};
+
+// Copies source, applies s (unless insert is false: outside the boundary)
+// and counts the obtuse triangles of the copy. Tasks on several workers copy
+// the same live triangulation at once: its structure is only read, and the
+// lazy Epeck values shared with the copies are thread safe with
+// CGAL_HAS_THREADS (without it the scheduler runs no pool threads). The
+// owning thread must not change source between the first submit and the wait.
+template <typename T>
+void evaluateTrial(Graph& source, Point a, Point b, Point c, const Point& s, int strategy, bool insert, bool keep, TrialResult& result) {
+    auto start = std::chrono::steady_clock::now();
+
+    unique_ptr<CDT> trial(new CDT(*source.cdt));
+    Graph graph_trial;
+    graph_trial.cdt = trial.get();
+    graph_trial.boundaryPolygon = source.boundaryPolygon;
+
+    if (insert) {
+        result.vertex = steiner_stategies::applySteinerPoint(graph_trial, a, b, c, s, strategy);
+    }
+
+    result.obtuse_triangles = T::countObtuseTriangles(*trial, *source.boundaryPolygon);
+    result.evaluated = true;
+
+    if (keep) {
+        result.cdt = std::move(trial);
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
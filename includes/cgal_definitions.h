@@ -9,8 +9,13 @@
 #include <CGAL/Lazy_exact_nt.h>
 #include <CGAL/squared_distance_2.h>
 #include <CGAL/convex_hull_2.h>
+#include <CGAL/Triangulation_vertex_base_with_info_2.h>
+#include <CGAL/Triangulation_face_base_with_info_2.h>
+#include <CGAL/Constrained_triangulation_face_base_2.h>
+#include <CGAL/Triangulation_data_structure_2.h>
 
 #include "CustomConstrainedDelaunayTriangulation_2.h"
+#include "triangulation_info.h"
 
 #define BOOST_BIND_GLOBAL_PLACEHOLDERS
 
@@ -22,7 +27,11 @@ typedef CGAL::Polygon_2<K> Polygon;
 typedef K::Line_2 Line;
 
 typedef CGAL::Exact_predicates_tag Itag;
-typedef CustomConstrainedDelaunayTriangulation_2<K, CGAL::Default, Itag> CDT;
+typedef CGAL::Triangulation_vertex_base_with_info_2<VertexInfo, K> Vb;
+typedef CGAL::Triangulation_face_base_with_info_2<FaceInfo, K> Fbi;
+typedef CGAL::Constrained_triangulation_face_base_2<K, Fbi> Fb;
+typedef CGAL::Triangulation_data_structure_2<Vb, Fb> Tds;
+typedef CustomConstrainedDelaunayTriangulation_2<K, Tds, Itag> CDT;
 typedef CDT::Point Point;
 typedef CDT::Edge Edge;
 typedef CDT::Face Face;
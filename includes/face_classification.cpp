@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "face_classification.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FACE_CLASSIFICATION_X86 1
+#include <immintrin.h>
+#else
+#define FACE_CLASSIFICATION_X86 0
+#endif
+
+using namespace std;
+
+//
+// The angle at p is obtuse iff (q - p) . (r - p) < 0. With every coordinate
+// off by at most err, each difference is off by delta = 2 err plus its own
+// rounding, so the dot product is off by at most
+//     2 (4 m delta + 2 delta^2 + 6 eps m^2)
+// where m bounds the magnitude of the differences (the factor 2 covers the
+// rounding of the bound itself).
+//
+
+static inline int angle_sign(double px, double py, double qx, double qy, double rx, double ry, double err) {
+    double ux = qx - px;
+    double uy = qy - py;
+    double vx = rx - px;
+    double vy = ry - py;
+
+    double m = std::max(std::max(std::fabs(ux), std::fabs(uy)), std::max(std::fabs(vx), std::fabs(vy)));
+    double delta = 2 * err + DBL_EPSILON * m;
+
+    m += delta;
+
+    double bound = 2 * (4 * m * delta + 2 * delta * delta + 6 * DBL_EPSILON * m * m);
+    double dot = ux * vx + uy * vy;
+
+    if (dot < -bound) {
+        return -1; // obtuse
+    }
+
+    if (dot > bound) {
+        return 1; // acute
+    }
+
+    return 0;
+}
+
+void face_classification::classify_scalar(const Batch& batch, size_t begin, size_t end, unsigned char* status) {
+    for (size_t i = begin; i < end; i++) {
+        double ax = batch.ax[i], ay = batch.ay[i];
+        double bx = batch.bx[i], by = batch.by[i];
+        double cx = batch.cx[i], cy = batch.cy[i];
+        double err = batch.err[i];
+
+        int sa = angle_sign(ax, ay, bx, by, cx, cy, err);
+        int sb = angle_sign(bx, by, ax, ay, cx, cy, err);
+        int sc = angle_sign(cx, cy, ax, ay, bx, by, err);
+
+        if (sa < 0 || sb < 0 || sc < 0) {
+            status[i] = OBTUSE;
+        } else if (sa > 0 && sb > 0 && sc > 0) {
+            status[i] = NOT_OBTUSE;
+        } else {
+            status[i] = AMBIGUOUS;
+        }
+    }
+}
+
+#if FACE_CLASSIFICATION_X86
+
+//
+// AVX2: 4 faces per iteration
+//
+
+__attribute__((target("avx2"))) static inline __m256d abs_pd(__m256d x) {
+    return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+}
+
+// Writes the obtuse (dot < -bound) and acute (dot > bound) lane masks
+__attribute__((target("avx2"))) static inline void angle_masks(__m256d px, __m256d py, __m256d qx, __m256d qy, __m256d rx, __m256d ry, __m256d err, __m256d& obtuse, __m256d& acute) {
+    const __m256d eps = _mm256_set1_pd(DBL_EPSILON);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d six = _mm256_set1_pd(6.0);
+
+    __m256d ux = _mm256_sub_pd(qx, px);
+    __m256d uy = _mm256_sub_pd(qy, py);
+    __m256d vx = _mm256_sub_pd(rx, px);
+    __m256d vy = _mm256_sub_pd(ry, py);
+
+    __m256d m = _mm256_max_pd(_mm256_max_pd(abs_pd(ux), abs_pd(uy)), _mm256_max_pd(abs_pd(vx), abs_pd(vy)));
+    __m256d delta = _mm256_add_pd(_mm256_mul_pd(two, err), _mm256_mul_pd(eps, m));
+
+    m = _mm256_add_pd(m, delta);
+
+    __m256d bound = _mm256_mul_pd(four, _mm256_mul_pd(m, delta));
+    bound = _mm256_add_pd(bound, _mm256_mul_pd(two, _mm256_mul_pd(delta, delta)));
+    bound = _mm256_add_pd(bound, _mm256_mul_pd(six, _mm256_mul_pd(eps, _mm256_mul_pd(m, m))));
+    bound = _mm256_mul_pd(two, bound);
+
+    __m256d dot = _mm256_add_pd(_mm256_mul_pd(ux, vx), _mm256_mul_pd(uy, vy));
+
+    obtuse = _mm256_cmp_pd(dot, _mm256_sub_pd(_mm256_setzero_pd(), bound), _CMP_LT_OQ);
+    acute = _mm256_cmp_pd(dot, bound, _CMP_GT_OQ);
+}
+
+__attribute__((target("avx2"))) void face_classification::classify_avx2(const Batch& batch, size_t begin, size_t end, unsigned char* status) {
+    size_t i = begin;
+
+    for (; i + 4 <= end; i += 4) {
+        __m256d ax = _mm256_loadu_pd(batch.ax + i), ay = _mm256_loadu_pd(batch.ay + i);
+        __m256d bx = _mm256_loadu_pd(batch.bx + i), by = _mm256_loadu_pd(batch.by + i);
+        __m256d cx = _mm256_loadu_pd(batch.cx + i), cy = _mm256_loadu_pd(batch.cy + i);
+        __m256d err = _mm256_loadu_pd(batch.err + i);
+
+        __m256d oa, ob, oc, na, nb, nc;
+
+        angle_masks(ax, ay, bx, by, cx, cy, err, oa, na);
+        angle_masks(bx, by, ax, ay, cx, cy, err, ob, nb);
+        angle_masks(cx, cy, ax, ay, bx, by, err, oc, nc);
+
+        int obtuse = _mm256_movemask_pd(_mm256_or_pd(_mm256_or_pd(oa, ob), oc));
+        int acute = _mm256_movemask_pd(_mm256_and_pd(_mm256_and_pd(na, nb), nc));
+
+        for (int lane = 0; lane < 4; lane++) {
+            if (obtuse & (1 << lane)) {
+                status[i + lane] = OBTUSE;
+            } else if (acute & (1 << lane)) {
+                status[i + lane] = NOT_OBTUSE;
+            } else {
+                status[i + lane] = AMBIGUOUS;
+            }
+        }
+    }
+
+    classify_scalar(batch, i, end, status);
+}
+
+//
+// AVX-512: 8 faces per iteration
+//
+
+__attribute__((target("avx512f"))) static inline void angle_masks(__m512d px, __m512d py, __m512d qx, __m512d qy, __m512d rx, __m512d ry, __m512d err, __mmask8& obtuse, __mmask8& acute) {
+    const __m512d eps = _mm512_set1_pd(DBL_EPSILON);
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512d six = _mm512_set1_pd(6.0);
+
+    __m512d ux = _mm512_sub_pd(qx, px);
+    __m512d uy = _mm512_sub_pd(qy, py);
+    __m512d vx = _mm512_sub_pd(rx, px);
+    __m512d vy = _mm512_sub_pd(ry, py);
+
+    __m512d m = _mm512_max_pd(_mm512_max_pd(_mm512_abs_pd(ux), _mm512_abs_pd(uy)), _mm512_max_pd(_mm512_abs_pd(vx), _mm512_abs_pd(vy)));
+    __m512d delta = _mm512_add_pd(_mm512_mul_pd(two, err), _mm512_mul_pd(eps, m));
+
+    m = _mm512_add_pd(m, delta);
+
+    __m512d bound = _mm512_mul_pd(four, _mm512_mul_pd(m, delta));
+    bound = _mm512_add_pd(bound, _mm512_mul_pd(two, _mm512_mul_pd(delta, delta)));
+    bound = _mm512_add_pd(bound, _mm512_mul_pd(six, _mm512_mul_pd(eps, _mm512_mul_pd(m, m))));
+    bound = _mm512_mul_pd(two, bound);
+
+    __m512d dot = _mm512_add_pd(_mm512_mul_pd(ux, vx), _mm512_mul_pd(uy, vy));
+
+    obtuse = _mm512_cmp_pd_mask(dot, _mm512_sub_pd(_mm512_setzero_pd(), bound), _CMP_LT_OQ);
+    acute = _mm512_cmp_pd_mask(dot, bound, _CMP_GT_OQ);
+}
+
+__attribute__((target("avx512f"))) void face_classification::classify_avx512(const Batch& batch, size_t begin, size_t end, unsigned char* status) {
+    size_t i = begin;
+
+    for (; i + 8 <= end; i += 8) {
+        __m512d ax = _mm512_loadu_pd(batch.ax + i), ay = _mm512_loadu_pd(batch.ay + i);
+        __m512d bx = _mm512_loadu_pd(batch.bx + i), by = _mm512_loadu_pd(batch.by + i);
+        __m512d cx = _mm512_loadu_pd(batch.cx + i), cy = _mm512_loadu_pd(batch.cy + i);
+        __m512d err = _mm512_loadu_pd(batch.err + i);
+
+        __mmask8 oa, ob, oc, na, nb, nc;
+
+        angle_masks(ax, ay, bx, by, cx, cy, err, oa, na);
+        angle_masks(bx, by, ax, ay, cx, cy, err, ob, nb);
+        angle_masks(cx, cy, ax, ay, bx, by, err, oc, nc);
+
+        unsigned int obtuse = oa | ob | oc;
+        unsigned int acute = na & nb & nc;
+
+        for (int lane = 0; lane < 8; lane++) {
+            if (obtuse & (1u << lane)) {
+                status[i + lane] = OBTUSE;
+            } else if (acute & (1u << lane)) {
+                status[i + lane] = NOT_OBTUSE;
+            } else {
+                status[i + lane] = AMBIGUOUS;
+            }
+        }
+    }
+
+    classify_scalar(batch, i, end, status);
+}
+
+#else
+
+void face_classification::classify_avx2(const Batch& batch, size_t begin, size_t end, unsigned char* status) {
+    classify_scalar(batch, begin, end, status);
+}
+
+void face_classification::classify_avx512(const Batch& batch, size_t begin, size_t end, unsigned char* status) {
+    classify_scalar(batch, begin, end, status);
+}
+
+#endif
+
+typedef void (*ClassifyKernel)(const face_classification::Batch&, size_t, size_t, unsigned char*);
+
+static ClassifyKernel select_kernel(const char*& name) {
+#if FACE_CLASSIFICATION_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f")) {
+        name = "avx512";
+        return face_classification::classify_avx512;
+    }
+
+    if (__builtin_cpu_supports("avx2")) {
+        name = "avx2";
+        return face_classification::classify_avx2;
+    }
+#endif
+
+    name = "scalar";
+    return face_classification::classify_scalar;
+}
+
+static const char* kernel = nullptr;
+static ClassifyKernel active = select_kernel(kernel);
+
+void face_classification::classify(const Batch& batch, size_t begin, size_t end, unsigned char* status) {
+    active(batch, begin, end, status);
+}
+
+const char* face_classification::kernel_name() {
+    return kernel;
+}
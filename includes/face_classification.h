@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+//
+// Batch obtuse classification of triangles given as double approximations in
+// structure-of-arrays form. Every coordinate of face i is known up to err[i];
+// a face whose angles cannot be decided within that error is reported as
+// AMBIGUOUS and must be resolved with the exact predicate.
+//
+namespace face_classification {
+    enum Status : unsigned char {
+        NOT_OBTUSE = 0,
+        OBTUSE = 1,
+        AMBIGUOUS = 2,
+    };
+
+    struct Batch {
+        const double* ax;
+        const double* ay;
+        const double* bx;
+        const double* by;
+        const double* cx;
+        const double* cy;
+        const double* err;
+    };
+
+    // Picks the widest instruction set supported by the running CPU
+    void classify(const Batch& batch, size_t begin, size_t end, unsigned char* status);
+
+    void classify_scalar(const Batch& batch, size_t begin, size_t end, unsigned char* status);
+
+    void classify_avx2(const Batch& batch, size_t begin, size_t end, unsigned char* status);
+
+    void classify_avx512(const Batch& batch, size_t begin, size_t end, unsigned char* status);
+
+    const char* kernel_name();
+}
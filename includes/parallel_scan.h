@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// CGAL_HAS_THREADS
+#include <CGAL/config.h>
+
+// Configuration
+#include "triangulation_configuration.h"
+
+// Support classes
+#include "TaskScheduler.h"
+
+//
+// Minimal parallel loops for read-only passes over a triangulation. The range
+// [0, n) is cut into chunks of `grain` items; every worker, the calling thread
+// included, keeps claiming the next unclaimed chunk until none is left, so
+// faster threads take over the work of slower ones. The workers are the
+// threads of one TaskScheduler kept for the whole run, so a loop costs a few
+// queue operations rather than thread creation. Workers read the shared
+// triangulation, lazy Epeck values included, which CGAL_HAS_THREADS makes
+// thread safe; nothing here may be used while the triangulation is being
+// modified. Loops started on a worker run inline, so engines may scan their
+// own copies from inside a parallel loop.
+//
+namespace parallel_scan {
+    inline unsigned int threads() {
+#if PARALLEL_SCAN_THREADS > 0
+        return PARALLEL_SCAN_THREADS;
+#elif defined(CGAL_HAS_THREADS)
+        return std::max(1u, std::thread::hardware_concurrency());
+#else
+        return 1; // lazy exact numbers are only thread safe with CGAL_HAS_THREADS
+#endif
+    }
+
+    // Whether the calling thread is running a chunk of a parallel loop
+    inline bool& in_worker() {
+        thread_local bool flag = false;
+
+        return flag;
+    }
+
+    // The scan workers next to the calling thread, started on first use
+    inline TaskScheduler& pool() {
+        static TaskScheduler scheduler(threads() - 1);
+
+        return scheduler;
+    }
+
+    // body(begin, end) is called once per chunk
+    template <typename Body>
+    void parallel_for(size_t n, size_t grain, const Body& body) {
+        grain = std::max<size_t>(grain, 1);
+
+        size_t chunks = (n + grain - 1) / grain;
+        unsigned int workers = (unsigned int)std::min<size_t>(threads(), chunks);
+
+        if (workers <= 1 || in_worker()) {
+            if (n > 0) {
+                body(0, n);
+            }
+
+            return;
+        }
+
+        std::atomic<size_t> next(0);
+
+        auto work = [&](unsigned int) {
+            bool nested = in_worker();
+
+            in_worker() = true;
+
+            for (size_t chunk = next++; chunk < chunks; chunk = next++) {
+                size_t begin = chunk * grain;
+
+                body(begin, std::min(begin + grain, n));
+            }
+
+            in_worker() = nested;
+        };
+
+        TaskScheduler& scheduler = pool();
+        TaskScheduler::Group group;
+
+        for (unsigned int t = 0; t < workers; t++) { // one claiming loop per worker; the waiting thread runs one too
+            scheduler.submit(group, work, t);
+        }
+
+        scheduler.wait(group);
+    }
+
+    // Combines map(begin, end) over all chunks, in chunk order
+    template <typename Value, typename Map, typename Combine>
+    Value parallel_reduce(size_t n, size_t grain, Value identity, const Map& map, const Combine& combine) {
+        grain = std::max<size_t>(grain, 1);
+
+        std::vector<Value> partial((n + grain - 1) / grain, identity);
+
+        parallel_for(n, grain, [&](size_t begin, size_t end) {
+            partial[begin / grain] = map(begin, end);
+        });
+
+        Value result = identity;
+
+        for (const Value& value : partial) {
+            result = combine(result, value);
+        }
+
+        return result;
+    }
+}
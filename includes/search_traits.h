@@ -0,0 +1,55 @@
+#pragma once
+
+// Macros and headers for CGAL
+#include "cgal_definitions.h"
+
+// Configuration
+#include "triangulation_configuration.h"
+
+// Support classes
+#include "FaceSnapshot.h"
+#include "utils.hpp"
+
+//
+// Kernel used by the search engines to classify triangles; engines take the
+// traits as their template argument. Only the exact kernel K is provided: the
+// triangulation, utils and the strategies are all built on K, so a cheaper
+// kernel here would have to convert three lazy points for every test, which
+// costs about as much as the exact test itself, and could export faces it
+// misclassified. An inexact search needs the triangulation itself on that
+// kernel first.
+//
+template <class Kernel>
+class SearchTraits_2;
+
+// The exact kernel: forward to utils
+template <>
+class SearchTraits_2<K> {
+public:
+    static bool is_obtuse(const Point& a, const Point& b, const Point& c) {
+        return find_obtuse_angle(a, b, c) >= 0;
+    }
+
+    static int find_obtuse_angle(const Point& a, const Point& b, const Point& c) {
+        Point pa = a, pb = b, pc = c;
+        return utils::find_obtuse_angle(pa, pb, pc);
+    }
+
+    static int countObtuseTriangles(CDT& cdt, const Polygon_2& boundaryPolygon) {
+        return utils::countObtuseTriangles(cdt, boundaryPolygon);
+    }
+
+    static vector<CDT::Face_handle> obtuseFaces(CDT& cdt) {
+        FaceSnapshot snapshot(cdt);
+
+        snapshot.classify();
+
+        vector<CDT::Face_handle> faces = snapshot.obtuseFaces();
+
+        utils::traversal_order(faces);
+
+        return faces;
+    }
+};
+
+typedef SearchTraits_2<K> SearchTraits;
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <iostream>
 #include <cmath>
 #include <vector>
@@ -6,6 +7,7 @@
 #include "cgal_definitions.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
+#include "triangulation_configuration.h"
 
 
 using namespace std;
@@ -34,9 +36,7 @@ Point * steiner_stategies::generateSteinerPointFromPericenter(Graph & graph, Poi
     return p;
 }
 
-Point * steiner_stategies::generateSteinerPointInsideConvexHull(Graph & graph, Point& a, Point& b, Point& c) {
-    CDT & cdt = *(graph.cdt);
-
+vector<Point> steiner_stategies::convexRegion(Graph & graph, Point& a, Point& b, Point& c) {
     // cout << "Examining triangle " << a << " " << b << " " << c << endl;
 
     vector<Point> boundary;
@@ -65,8 +65,6 @@ Point * steiner_stategies::generateSteinerPointInsideConvexHull(Graph & graph, P
                 continue;
             }
 
-            
-
             if (neighbor_vertex_index == 0) {
                 // cout << "Adding vertex to boundary (case 0): " << aa << endl;
                 boundary.emplace_back(aa);
@@ -88,28 +86,56 @@ Point * steiner_stategies::generateSteinerPointInsideConvexHull(Graph & graph, P
         }
     }
 
+    return boundary;
+}
+
+Point * steiner_stategies::generateSteinerPointInsideConvexHull(Graph & graph, Point& a, Point& b, Point& c) {
+    vector<Point> boundary = convexRegion(graph, a, b, c);
+
+    Point centroid = utils::centroid(boundary);
+    return new Point(centroid);
+}
+
+void steiner_stategies::constrainConvexRegion(Graph & graph, const vector<Point> & boundary) {
+    CDT & cdt = *(graph.cdt);
+
     if (boundary.size() > 3) {
         for (unsigned int i=0;i<boundary.size() - 1;i++) {
-            Point & p = boundary[i];
-            Point & q = boundary[i+1];
+            const Point & p = boundary[i];
+            const Point & q = boundary[i+1];
             // cout << "Adding boundary: " << p << " to " << q << endl;
             cdt.insert_constraint(p,q);
         }
 
-        Point & p = boundary[boundary.size()-1];
-        Point & q = boundary[0];
+        const Point & p = boundary[boundary.size()-1];
+        const Point & q = boundary[0];
 
         // cout << "Adding boundary: " << p << " to " << q << endl;
 
         cdt.insert_constraint(p,q);
+    }
+}
 
+Vertex_handle steiner_stategies::applySteinerPoint(Graph & graph, Point& a, Point& b, Point& c, const Point& s, Strategy strategy, CDT::Face_handle hint) {
+    vector<Point> region;
 
-        Point centroid = utils::centroid(boundary);
-        return new Point(centroid);
-    } else {
-        Point centroid = utils::centroid(boundary);
-        return new Point(centroid);
+    if (strategy == POLYGON) {
+        region = convexRegion(graph, a, b, c); // while the face a, b, c still exists: the insertion destroys it
+
+        constrainConvexRegion(graph, region);
+
+        hint = CDT::Face_handle(); // the constraints may have destroyed the face
     }
+
+    Vertex_handle v = graph.cdt->insertByStrategy(s, strategy, hint);
+
+    removeConflictPoints(graph, region, strategy);
+
+    return v;
+}
+
+Vertex_handle steiner_stategies::applySteinerPoint(Graph & graph, Point& a, Point& b, Point& c, const Point& s, int strategy, CDT::Face_handle hint) {
+    return steiner_stategies::applySteinerPoint(graph, a, b, c, s, (Strategy)strategy, hint);
 }
 
 Point * steiner_stategies::generateSteinerPointProjection(Graph & graph, Point& a, Point& b, Point& c) {
@@ -144,15 +170,22 @@ Point * steiner_stategies::generateSteinerPointAltitude(Graph & graph, Point & a
 
 
 Point* steiner_stategies::generateSteinerPointRandom(Graph & graph, Point & a, Point & b, Point & c) {
+    // Convert once: the sampling loop below works in doubles only
+    double ax = CGAL::to_double(a.x()), ay = CGAL::to_double(a.y());
+    double bx = CGAL::to_double(b.x()), by = CGAL::to_double(b.y());
+    double cx = CGAL::to_double(c.x()), cy = CGAL::to_double(c.y());
+
     // Calculate the barycenter of the triangle
-    double barycenter_x = CGAL::to_double(a.x() + b.x() + c.x()) / 3.0;
-    double barycenter_y = CGAL::to_double(a.y() + b.y() + c.y()) / 3.0;
+    double barycenter_x = (ax + bx + cx) / 3.0;
+    double barycenter_y = (ay + by + cy) / 3.0;
 
     // Define the Gaussian distribution parameters
     std::random_device rd;
     std::mt19937 gen(rd());
-    std::normal_distribution<double> dist_x(barycenter_x, std::abs(CGAL::to_double((b.x() - a.x()) + (c.x() - a.x()))) / 6.0);
-    std::normal_distribution<double> dist_y(barycenter_y, std::abs(CGAL::to_double((b.y() - a.y()) + (c.y() - a.y()))) / 6.0);
+    std::normal_distribution<double> dist_x(barycenter_x, std::abs((bx - ax) + (cx - ax)) / 6.0);
+    std::normal_distribution<double> dist_y(barycenter_y, std::abs((by - ay) + (cy - ay)) / 6.0);
+
+    double denominator = (by - cy) * (ax - cx) + (cx - bx) * (ay - cy);
 
     Point* random_point = nullptr;
 
@@ -162,9 +195,8 @@ Point* steiner_stategies::generateSteinerPointRandom(Graph & graph, Point & a, P
         double y = dist_y(gen);
     
         // Check if the point is inside the triangle using barycentric coordinates
-        double denominator = CGAL::to_double((b.y() - c.y()) * (a.x() - c.x()) + (c.x() - b.x()) * (a.y() - c.y()));
-        double alpha = CGAL::to_double((b.y() - c.y()) * (x - c.x()) + (c.x() - b.x()) * (y - c.y())) / denominator;
-        double beta = CGAL::to_double((c.y() - a.y()) * (x - c.x()) + (a.x() - c.x()) * (y - c.y())) / denominator;
+        double alpha = ((by - cy) * (x - cx) + (cx - bx) * (y - cy)) / denominator;
+        double beta = ((cy - ay) * (x - cx) + (ax - cx) * (y - cy)) / denominator;
         double gamma = 1.0 - alpha - beta;
 
         if (alpha >= 0 && beta >= 0 && gamma >= 0) {
@@ -176,7 +208,9 @@ Point* steiner_stategies::generateSteinerPointRandom(Graph & graph, Point & a, P
     return random_point;
 }
 
-Point * steiner_stategies::generateSteinerPoint(Graph & graph, Point& a, Point& b, Point& c, Strategy strategy) {
+static Point * generate(Graph & graph, Point& a, Point& b, Point& c, steiner_stategies::Strategy strategy) {
+    using namespace steiner_stategies;
+
     if (strategy == MAX_EDGE) {
         return generateSteinerPointFromMaxEdge(graph, a, b, c);
     }
@@ -212,59 +246,132 @@ Point * steiner_stategies::generateSteinerPoint(Graph & graph, Point& a, Point&
     return generateSteinerPointProjection(graph, a, b, c);
 }
 
+//
+// Bounded-denominator rounding
+//
+// Circumcenters and projections of earlier Steiner points have ever longer
+// numerators and denominators. A candidate is snapped to the nearest point of
+// the grid of multiples of 1/d, for d = D, D^2, ... and the first snap that
+// changes nothing about the insertion is kept: it lies strictly inside the
+// same face (so insert_no_flip splits the same triangle), is a valid Steiner
+// point, and each of the three new triangles is obtuse exactly when it would
+// have been with the original point.
+//
+
+static long rounding_denominator = STEINER_ROUNDING_DENOMINATOR;
+
+// Atomic: candidates may be generated on several threads (see ParallelLocalSearch)
+static std::atomic<unsigned long> rounded_points(0);
+static std::atomic<unsigned long> unrounded_points(0);
+static std::atomic<unsigned long> bits_before(0);
+static std::atomic<unsigned long> bits_after(0);
+
+// Largest grid tried, so that every snapped coordinate is an exact double over d
+static const double MAX_ROUNDING_DENOMINATOR = 1073741824.0; // 2^30
+
+static bool snap(const Point& p, double denominator, Point& snapped) {
+    double x = std::round(CGAL::to_double(p.x()) * denominator);
+    double y = std::round(CGAL::to_double(p.y()) * denominator);
+
+    if (!(std::fabs(x) < 9007199254740992.0) || !(std::fabs(y) < 9007199254740992.0)) { // 2^53
+        return false;
+    }
 
+    snapped = Point(K::FT(x) / K::FT(denominator), K::FT(y) / K::FT(denominator));
 
+    return true;
+}
 
-void steiner_stategies::removeConflictPointsInsideConvexHull(Graph & graph, Point & a, Point & b, Point &c) {
-    CDT & cdt = *(graph.cdt);
+static bool same_outcome(CDT& cdt, CDT::Face_handle face, Point& p, Point& q) {
+    CDT::Locate_type lt;
+    int li;
 
-    vector<Point> boundary;
+    if (cdt.locate(q, lt, li, face) != face || lt != CDT::FACE) {
+        return false;
+    }
 
-    boundary.emplace_back(a);
-    boundary.emplace_back(b);
-    boundary.emplace_back(c);
+    for (int i = 0; i < 3; i++) {
+        Point a = face->vertex(cdt.ccw(i))->point();
+        Point b = face->vertex(cdt.cw(i))->point();
 
-    for (int vertex_index=0;vertex_index<3;vertex_index++) {
-        int neighbor_vertex_index = 0;
+        if (utils::is_obtuse(p, a, b) != utils::is_obtuse(q, a, b)) {
+            return false;
+        }
+    }
 
-        Face * face = utils::findNeighbor(graph, a, b, c, vertex_index, neighbor_vertex_index);
+    return true;
+}
 
-        if (face == nullptr) {
-            // cout << "\tDirection " << vertex_index << ", No neighbor found " << endl;
-        } else {
-            Point aa = face->vertex(0)->point(); 
-            Point bb = face->vertex(1)->point();
-            Point cc = face->vertex(2)->point();
+static void round_steiner_point(Graph & graph, Point * p, CDT::Face_handle hint) {
+    CDT & cdt = *(graph.cdt);
 
-            bool is_obtuse = utils::find_obtuse_angle(aa,bb,cc) >= 0;
+    if (!utils::is_steiner_point_valid(*graph.boundaryPolygon, *p, cdt.domain_index)) { // rejected by the caller anyway
+        return;
+    }
 
-            // cout << "\tDirection " << vertex_index << ", Face: " << face->vertex(0)->point() << " " << face->vertex(1)->point() << " " << face->vertex(2)->point() << ", obtuse: " << is_obtuse << endl;
+    CDT::Locate_type lt;
+    int li;
 
-            if (!is_obtuse) {                
-                continue;
-            }
+    CDT::Face_handle face = cdt.locate(*p, lt, li, hint);
 
-            if (neighbor_vertex_index == 0) {
-                // cout << "Adding vertex to boundary (case 0): " << aa << endl;
-                boundary.emplace_back(aa);
-            } else if (neighbor_vertex_index == 1) {
-                // cout << "Adding vertex to boundary (case 1): " << bb << endl;
-                boundary.emplace_back(bb);
-            } else if (neighbor_vertex_index == 2) {
-                // cout << "Adding vertex to boundary (case 2): " << cc << endl;
-                boundary.emplace_back(cc);
-            } else {
-                // cout << "Invalid index" << neighbor_vertex_index << endl;
-                exit(1);
-            }
+    if (lt != CDT::FACE) { // on an edge or a vertex: moving the point changes what gets split
+        return;
+    }
 
-            if (!utils::is_convex(boundary)) {
-                boundary.pop_back();
-                // cout << "Polygon not convex \n";
-            }
+    for (double d = rounding_denominator; d <= MAX_ROUNDING_DENOMINATOR; d *= rounding_denominator) {
+        Point q;
+
+        if (!snap(*p, d, q)) {
+            break;
+        }
+
+        if (utils::is_steiner_point_valid(*graph.boundaryPolygon, q, cdt.domain_index) && same_outcome(cdt, face, *p, q)) {
+            bits_before += utils::coordinate_bits(p->x()) + utils::coordinate_bits(p->y());
+            bits_after += utils::coordinate_bits(q.x()) + utils::coordinate_bits(q.y());
+            rounded_points++;
+
+            *p = q;
+            return;
         }
+
+        if (rounding_denominator < 2) {
+            break;
+        }
+    }
+
+    unrounded_points++;
+}
+
+Point * steiner_stategies::generateSteinerPoint(Graph & graph, Point& a, Point& b, Point& c, Strategy strategy, CDT::Face_handle hint) {
+    Point * p = generate(graph, a, b, c, strategy);
+
+    // The polygon strategy re-triangulates around its point, so only points inserted without flips are rounded
+    if (p != nullptr && rounding_denominator > 0 && strategy != POLYGON) {
+        round_steiner_point(graph, p, hint);
+    }
+
+    return p;
+}
+
+void steiner_stategies::setRoundingDenominator(long denominator) {
+    rounding_denominator = denominator;
+}
+
+void steiner_stategies::printRounding() {
+    if (rounding_denominator <= 0) {
+        return;
     }
 
+    cout << "Rounded Steiner points: " << rounded_points.load() << " of " << rounded_points.load() + unrounded_points.load() << " (grid 1/" << rounding_denominator << ")" << endl;
+    cout << "Steiner coordinate bits: " << bits_before.load() << " -> " << bits_after.load() << " (" << (long)bits_before.load() - (long)bits_after.load() << " saved)" << endl;
+}
+
+
+
+
+void steiner_stategies::removeConflictPointsInsideConvexHull(Graph & graph, const vector<Point> & boundary) {
+    CDT & cdt = *(graph.cdt);
+
     if (boundary.size() > 3) {
         // remove all points within the boundary
 
@@ -294,23 +401,16 @@ void steiner_stategies::removeConflictPointsInsideConvexHull(Graph & graph, Poin
 
 
 
-void steiner_stategies::removeConflictPoints(Graph & graph, Point & a, Point & b, Point &c, Strategy strategy) {
+void steiner_stategies::removeConflictPoints(Graph & graph, const vector<Point> & region, Strategy strategy) {
     if (strategy == POLYGON) {
-        return removeConflictPointsInsideConvexHull(graph, a, b, c);
+        return removeConflictPointsInsideConvexHull(graph, region);
     } else {
         return;
     }
 }
 
-void steiner_stategies::removeConflictPoints(Graph & graph, Point & a, Point & b, Point &c, int strategy) {
-    steiner_stategies::removeConflictPoints(graph, a, b,c , (Strategy)strategy);
-}
-
-void steiner_stategies::removeConflictPoints(CDT & cdt, Point & a, Point & b, Point &c, int strategy) {
-    Graph graph;
-    graph.cdt = &cdt;
-
-    steiner_stategies::removeConflictPoints(graph, a, b, c, strategy);    
+void steiner_stategies::removeConflictPoints(Graph & graph, const vector<Point> & region, int strategy) {
+    steiner_stategies::removeConflictPoints(graph, region, (Strategy)strategy);
 }
 
 Point * steiner_stategies::generateSteinerPointCentroid(Graph & graph, Point & a, Point & b, Point &c) {
@@ -4,6 +4,7 @@
 #include "graph_definitions.h"
 
 using std::string;
+using std::vector;
 
 namespace steiner_stategies {
     enum Strategy {
@@ -28,6 +29,7 @@ namespace steiner_stategies {
 
     Point * generateSteinerPointFromPericenter(Graph & graph, Point & a, Point & b, Point &c);
 
+    // Centroid of the region convexRegion merges around the face; leaves the triangulation unchanged
     Point * generateSteinerPointInsideConvexHull(Graph & graph, Point & a, Point & b, Point &c);
 
     Point * generateSteinerPointProjection(Graph & graph, Point & a, Point & b, Point &c);
@@ -36,23 +38,46 @@ namespace steiner_stategies {
 
     Point * generateSteinerPointRandom(Graph & graph, Point & a, Point & b, Point &c);
 
-    Point * generateSteinerPoint(Graph & graph, Point & a, Point & b, Point &c, Strategy strategy);
+    // Runs the strategy, then snaps the point to a bounded-denominator grid when rounding is on.
+    // hint: the face a, b, c of graph.cdt, if the caller holds it (speeds up point location)
+    Point * generateSteinerPoint(Graph & graph, Point & a, Point & b, Point &c, Strategy strategy, CDT::Face_handle hint = CDT::Face_handle());
+
+    // Rounds Steiner points to multiples of 1/denominator (or its powers); 0 turns rounding off
+    void setRoundingDenominator(long denominator);
+
+    void printRounding();
 
 
     Point * generateSteinerPointBiSector(Graph & graph, Point & a, Point & b, Point &c);
 
     Point * generateSteinerPointAltitude(Graph & graph, Point & a, Point & b, Point &c);
 
+    //
+    // POLYGON strategy: the face merged with its obtuse neighbors while the union stays convex
+    //
+    vector<Point> convexRegion(Graph & graph, Point & a, Point & b, Point &c);
+
+    // Constrains the edges of the merged region (when the face was merged with a neighbor)
+    void constrainConvexRegion(Graph & graph, const vector<Point> & region);
+
+    //
+    // Apply a generated point: constrain its region (POLYGON), insert it and remove
+    // the points it conflicts with. Generation itself never changes the triangulation.
+    // hint: the face a, b, c of graph.cdt, where locating s starts (see insertByStrategy)
+    //
+    Vertex_handle applySteinerPoint(Graph & graph, Point & a, Point & b, Point &c, const Point & s, Strategy strategy, CDT::Face_handle hint = CDT::Face_handle());
+
+    Vertex_handle applySteinerPoint(Graph & graph, Point & a, Point & b, Point &c, const Point & s, int strategy, CDT::Face_handle hint = CDT::Face_handle());
+
     //
     // Remove points if needed
     //
-    void removeConflictPointsInsideConvexHull(Graph & graph, Point & a, Point & b, Point &c);
+    // region: the convexRegion of the face, computed before the point was inserted
+    void removeConflictPointsInsideConvexHull(Graph & graph, const vector<Point> & region);
 
-    void removeConflictPoints(Graph & graph, Point & a, Point & b, Point &c, Strategy strategy);
+    void removeConflictPoints(Graph & graph, const vector<Point> & region, Strategy strategy);
 
-    void removeConflictPoints(Graph & graph, Point & a, Point & b, Point &c, int strategy);
-   
-    void removeConflictPoints(CDT & cdt, Point & a, Point & b, Point &c, int strategy);
+    void removeConflictPoints(Graph & graph, const vector<Point> & region, int strategy);
 }
 
 
@@ -6,4 +6,49 @@
 
 #define ENABLE_RANDOMIZATION_METHOD true
 
-#define RANDOMIZATION_RETRIES 10
\ No newline at end of file
+#define RANDOMIZATION_RETRIES 10
+
+// UCB strategy selection: stop evaluating a face once a candidate removes this many obtuse triangles
+#define BANDIT_EARLY_EXIT_REDUCTION 1
+
+// Make every committed Steiner point exact, pruning its lazy construction DAG
+#define EXACT_COLLAPSE_ON_COMMIT true
+
+// Make all vertices exact every this many commits (0: never)
+#define EXACT_COLLAPSE_INTERVAL 32
+
+// Worker threads for read-only face scans (0: one per hardware thread)
+#define PARALLEL_SCAN_THREADS 0
+
+// Faces per chunk handed to a worker by the parallel face scans
+#define PARALLEL_SCAN_GRAIN 1024
+
+// Snap Steiner points to multiples of 1/this (or its powers) when that keeps the outcome (0: off, -D overrides)
+#define STEINER_ROUNDING_DENOMINATOR 0
+
+// Start point locations without a hint from a grid of nearby vertices (jump and walk)
+#define USE_LOCATE_GRID false
+
+// Vertices below which the locate grid is not worth building
+#define LOCATE_GRID_MIN_VERTICES 2048
+
+// Visit face worklists along a Hilbert curve over the face centroids (SA then sweeps in that order instead of worst first)
+#define SPATIAL_FACE_ORDER false
+
+// Improving Steiner points with disjoint footprints committed together per LS iteration / SA sweep (1: one at a time)
+#define COMMIT_BATCH_SIZE 1
+
+// Pool threads evaluating trial insertions for the engines, next to the waiting thread (0: evaluate inline)
+#define TRIAL_SCHEDULER_THREADS 0
+
+// Deepest quadtree level of -m quadtree / qtls (at most 28)
+#define QUADTREE_MAX_DEPTH 16
+
+// Quadtree corners this close to an input point, in sides of its leaf, are replaced by the point
+#define QUADTREE_WARP_DISTANCE 0.3
+
+// Quadtree corners this close to the boundary, in sides of their smallest leaf, are not inserted
+#define QUADTREE_CLIP_DISTANCE 0.25
+
+// Largest right-angle grid, in nodes (x lines times y lines), built for -m ortho, -m ortholls and -O
+#define ORTHO_GRID_MAX_POINTS 250000
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+
+//
+// Data attached to the vertices and faces of the triangulation (see CDT in
+// cgal_definitions.h). Both are plain caches: they are copied together with
+// the triangulation and never affect its combinatorics.
+//
+
+struct VertexInfo {
+    // Unique among the vertices of a triangulation and kept by its copies.
+    // Starts at 1; 0 never names a vertex.
+    unsigned long index;
+
+    // Double approximation of the point, filled by utils::approximate
+    bool approximated = false;
+    double x = 0;
+    double y = 0;
+    double err = 0; // width of the widest coordinate interval
+
+    // Index of the instance point (see utils::buildTriangulation); -1 for Steiner points
+    int input = -1;
+
+    // Steiner constructions between the point and the nearest exact ancestors
+    // (see ExactCollapse); 0 for input points and collapsed points
+    unsigned int depth = 0;
+
+    VertexInfo() : index(next_index()) {
+    }
+
+private:
+    static unsigned long next_index() {
+        static std::atomic<unsigned long> counter(0);
+
+        return ++counter;
+    }
+};
+
+struct FaceInfo {
+    // Set when the face may have changed; cleared by utils::find_obtuse_angle
+    bool dirty = true;
+
+    bool obtuse = false;
+    signed char obtuse_vertex = -1; // same numbering as utils::find_obtuse_angle
+
+    // Vertex indices the cached values belong to: flips reuse faces
+    unsigned long vertices[3] = {0, 0, 0};
+
+    // Inside the boundary: 1 yes, 0 no, -1 not known yet (see utils::in_domain).
+    // Unaffected by flips and splits, which never cross the boundary.
+    signed char in_domain = -1;
+};
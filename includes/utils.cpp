@@ -1,9 +1,23 @@
+#include <algorithm>
 #include <cmath>
 #include <gmp.h>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <queue>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+#include <CGAL/Spatial_sort_traits_adapter_2.h>
+#include <CGAL/hilbert_sort.h>
+#include <CGAL/property_map.h>
+
+#include "BoundaryIndex.h"
 #include "cgal_definitions.h"
+#include "FaceSnapshot.h"
 #include "triangulation_configuration.h"
 #include "utils.hpp"
 
@@ -57,7 +71,7 @@ bool utils::checkConstraints(const CDT& cdt, const Polygon_2& boundaryPolygon, c
         Vertex_handle v1 = edge->first->vertex(cdt.cw(edge->second));
         Vertex_handle v2 = edge->first->vertex(cdt.ccw(edge->second));
 
-        if (utils::edge_inside_boundary(boundaryPolygon, v1, v2)) {
+        if (utils::edge_inside_boundary(boundaryPolygon, v1, v2, cdt.domain_index)) {
 
             if (cdt.is_constrained(edge_info)) {
 
@@ -114,6 +128,14 @@ string utils::coordinate_to_rational(const K::FT& coord) {
     return result;
 }
 
+size_t utils::coordinate_bits(const K::FT& coord) {
+    const auto exact_coord = CGAL::exact(coord);
+
+    const mpq_t* gmpq_ptr = reinterpret_cast<const mpq_t*>(&exact_coord);
+
+    return mpz_sizeinbase(mpq_numref(*gmpq_ptr), 2) + mpz_sizeinbase(mpq_denref(*gmpq_ptr), 2);
+}
+
 Point utils::findGeometricalMean(Polygon& polygon) {
     K::FT x_sum = 0;
     K::FT y_sum = 0;
@@ -146,73 +168,72 @@ bool utils::isConvex(Polygon& polygon) {
     return true;
 }
 
-Face* utils::findNeighbor(Graph& graph, Point& a, Point& b, Point& c, int vertex_index, int& neighbor_vertex_index) {
-    CDT& cdt = *(graph.cdt);
-    bool no_neighbor_because_of_constraint = false;
+static bool findVertex(CDT& cdt, const Point& p, Vertex_handle& v) {
+    CDT::Locate_type lt;
+    int li;
 
-    if (vertex_index == 0) {
-        no_neighbor_because_of_constraint = checkConstraints(cdt, *(graph.boundaryPolygon), b, c);
-    }
-    if (vertex_index == 1) {
-        no_neighbor_because_of_constraint = checkConstraints(cdt, *(graph.boundaryPolygon), a, c);
-    }
-    if (vertex_index == 2) {
-        no_neighbor_because_of_constraint = checkConstraints(cdt, *(graph.boundaryPolygon), a, b);
+    CDT::Face_handle face = cdt.locate(p, lt, li);
+
+    if (lt != CDT::VERTEX) {
+        return false;
     }
 
-    if (no_neighbor_because_of_constraint) {
+    v = face->vertex(li);
+
+    return true;
+}
+
+Face* utils::findNeighbor(CDT& cdt, const Polygon_2& boundaryPolygon, CDT::Face_handle face, int vertex_index, int& neighbor_vertex_index) {
+    Vertex_handle v1 = face->vertex(face->cw(vertex_index));
+    Vertex_handle v2 = face->vertex(face->ccw(vertex_index));
+
+    if (face->is_constrained(vertex_index) && utils::edge_inside_boundary(boundaryPolygon, v1, v2, cdt.domain_index)) {
         return nullptr;
     }
 
-    Point x, y;
+    CDT::Face_handle neighbor = face->neighbor(vertex_index);
 
-    if (vertex_index == 0) {
-        x = b;
-        y = c;
-    }
-    if (vertex_index == 1) {
-        x = a;
-        y = c;
-    }
-    if (vertex_index == 2) {
-        x = a;
-        y = b;
+    if (cdt.is_infinite(neighbor)) {
+        return nullptr;
     }
 
-    for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-        Point aa = fit->vertex(0)->point();
-        Point bb = fit->vertex(1)->point();
-        Point cc = fit->vertex(2)->point();
+    neighbor_vertex_index = neighbor->index(face);
 
-        if (aa == a && bb == b && cc == c) {
-            continue;
-        }
+    return &(*neighbor);
+}
 
-        if ((aa == x && bb == y) || (aa == y && bb == x)) {
-            neighbor_vertex_index = 2;
-            return &(*fit);
-        }
+Face* utils::findNeighbor(Graph& graph, Point& a, Point& b, Point& c, int vertex_index, int& neighbor_vertex_index) {
+    CDT& cdt = *(graph.cdt);
 
-        if ((bb == x && cc == y) || (bb == y && cc == x)) {
-            neighbor_vertex_index = 0;
-            return &(*fit);
-        }
+    Vertex_handle va, vb, vc;
 
-        if ((cc == x && aa == y) || (cc == y && aa == x)) {
-            neighbor_vertex_index = 1;
-            return &(*fit);
-        }
+    if (!findVertex(cdt, a, va) || !findVertex(cdt, b, vb) || !findVertex(cdt, c, vc)) {
+        return nullptr;
     }
 
-    return nullptr;
+    CDT::Face_handle face;
+
+    if (!cdt.is_face(va, vb, vc, face)) {
+        return nullptr;
+    }
+
+    Vertex_handle v = (vertex_index == 0) ? va : (vertex_index == 1) ? vb : vc;
+
+    return utils::findNeighbor(cdt, *(graph.boundaryPolygon), face, face->index(v), neighbor_vertex_index);
+}
+
+CGAL::Bounded_side utils::bounded_side(const Polygon_2& polygon, const Point& point, const BoundaryIndex* index) {
+    return (index != nullptr && index->indexes(polygon)) ? index->bounded_side(point) : polygon.bounded_side(point);
 }
 
 bool utils::is_point_inside_polygon(const Polygon_2& polygon, const Point& point) {
-    return polygon.bounded_side(point) == CGAL::ON_BOUNDED_SIDE;
+    return utils::bounded_side(polygon, point) == CGAL::ON_BOUNDED_SIDE;
 }
 
-bool utils::is_steiner_point_valid(const Polygon_2& polygon, const Point& point) {
-    return polygon.bounded_side(point) == CGAL::ON_BOUNDED_SIDE || (ALLOW_POINTS_ON_BOUNDARY && polygon.bounded_side(point) == CGAL::ON_BOUNDARY);
+bool utils::is_steiner_point_valid(const Polygon_2& polygon, const Point& point, const BoundaryIndex* index) {
+    CGAL::Bounded_side side = utils::bounded_side(polygon, point, index);
+
+    return side == CGAL::ON_BOUNDED_SIDE || (ALLOW_POINTS_ON_BOUNDARY && side == CGAL::ON_BOUNDARY);
 }
 
 Point utils::centroid(std::vector<Point>& points) {
@@ -261,19 +282,9 @@ bool utils::is_convex(const std::vector<Point>& boundary) {
 }
 
 int utils::countObtuseTriangles(CDT& cdt, const Polygon_2& boundaryPolygon) {
-    int counter = 0;
-
-    for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
-        Point a = fit->vertex(0)->point();
-        Point b = fit->vertex(1)->point();
-        Point c = fit->vertex(2)->point();
+    FaceSnapshot snapshot(cdt);
 
-        if (utils::is_obtuse(a, b, c)) {
-            counter++;
-        }
-    }
-
-    return counter;
+    return snapshot.classify();
 }
 
 double utils::average(vector<double>& values) {
@@ -299,17 +310,17 @@ double utils::calculate_p(int steiner_points, int step, int obtuse_triangles_bef
     return log(a / b) / log(c / d);
 }
 
-bool utils::edge_inside_boundary(const Polygon_2& boundaryPolygon, Point& p1, Point& p2) {
+bool utils::edge_inside_boundary(const Polygon_2& boundaryPolygon, Point& p1, Point& p2, const BoundaryIndex* index) {
     Point midpoint((p1.x() + p2.x()) / 2.0, (p1.y() + p2.y()) / 2.0);
 
-    return boundaryPolygon.bounded_side(midpoint) != CGAL::ON_UNBOUNDED_SIDE;
+    return utils::bounded_side(boundaryPolygon, midpoint, index) != CGAL::ON_UNBOUNDED_SIDE;
 }
 
-bool utils::edge_inside_boundary(const Polygon_2& boundaryPolygon, Vertex_handle v1, Vertex_handle v2) {
+bool utils::edge_inside_boundary(const Polygon_2& boundaryPolygon, Vertex_handle v1, Vertex_handle v2, const BoundaryIndex* index) {
     Point p1 = v1->point();
     Point p2 = v2->point();
 
-    return utils::edge_inside_boundary(boundaryPolygon, p1, p2);
+    return utils::edge_inside_boundary(boundaryPolygon, p1, p2, index);
 }
 
 bool utils::face_inside_boundary(const Polygon_2& boundaryPolygon, CDT::Face_handle& face) {
@@ -322,4 +333,463 @@ bool utils::face_inside_boundary(const Polygon_2& boundaryPolygon, CDT::Face_han
     bool x3 = utils::edge_inside_boundary(boundaryPolygon, p3, p1);
 
     return x1 && x2 && x3;
+}
+
+void utils::buildTriangulation(CDT& cdt, const vector<Point>& points, const vector<std::pair<int, int>>& constraints, const vector<int>& boundary) {
+    vector<std::pair<Point, VertexInfo>> located;
+
+    located.reserve(points.size());
+
+    for (size_t i = 0; i < points.size(); i++) {
+        VertexInfo info;
+        info.input = (int)i;
+
+        located.emplace_back(points[i], info);
+    }
+
+    cdt.insert(located.begin(), located.end()); // spatially sorted, each insertion starts next to the previous one
+
+    vector<Vertex_handle> handles(points.size());
+
+    for (auto vit = cdt.finite_vertices_begin(); vit != cdt.finite_vertices_end(); ++vit) {
+        if (vit->info().input >= 0) {
+            handles[vit->info().input] = vit;
+        }
+    }
+
+    for (size_t i = 0; i < points.size(); i++) {
+        if (handles[i] == Vertex_handle()) { // a duplicate point: merged into an earlier vertex
+            handles[i] = cdt.insert(points[i]);
+        }
+    }
+
+    // Between existing vertices: no point location at all
+    for (const auto& constraint : constraints) {
+        cdt.insert_constraint(handles[constraint.first], handles[constraint.second]);
+    }
+
+    for (size_t i = 0; i < boundary.size(); i++) {
+        cdt.insert_constraint(handles[boundary[i]], handles[boundary[(i + 1) % boundary.size()]]);
+    }
+}
+
+// A constrained edge lying on the domain's boundary (as opposed to an interior constraint)
+static bool is_boundary_edge(CDT& cdt, CDT::Face_handle face, int i) {
+    if (!face->is_constrained(i)) {
+        return false;
+    }
+
+    const Point& p1 = face->vertex(face->cw(i))->point();
+    const Point& p2 = face->vertex(face->ccw(i))->point();
+
+    return utils::bounded_side(*(cdt.domain), CGAL::midpoint(p1, p2), cdt.domain_index) == CGAL::ON_BOUNDARY;
+}
+
+void utils::markDomain(CDT& cdt, const Polygon_2& boundaryPolygon, const BoundaryIndex* index) {
+    cdt.domain = &boundaryPolygon;
+    cdt.domain_index = (index != nullptr && index->indexes(boundaryPolygon)) ? index : nullptr;
+
+    for (auto fit = cdt.all_faces_begin(); fit != cdt.all_faces_end(); ++fit) {
+        fit->info().in_domain = -1;
+    }
+
+    std::queue<CDT::Face_handle> queue;
+
+    cdt.infinite_face()->info().in_domain = 0;
+    queue.push(cdt.infinite_face());
+
+    while (!queue.empty()) {
+        CDT::Face_handle face = queue.front();
+
+        queue.pop();
+
+        for (int i = 0; i < 3; i++) {
+            CDT::Face_handle neighbor = face->neighbor(i);
+
+            if (neighbor->info().in_domain >= 0) {
+                continue;
+            }
+
+            bool toggle = is_boundary_edge(cdt, face, i); // edges at the infinite vertex are never constrained
+
+            neighbor->info().in_domain = toggle ? 1 - face->info().in_domain : face->info().in_domain;
+
+            queue.push(neighbor);
+        }
+    }
+}
+
+bool utils::in_domain(CDT& cdt, CDT::Face_handle face) {
+    if (cdt.is_infinite(face)) {
+        return false;
+    }
+
+    if (cdt.domain == nullptr) {
+        return true;
+    }
+
+    if (face->info().in_domain >= 0) {
+        return face->info().in_domain > 0;
+    }
+
+    // Walk unresolved faces until a flagged one; parity[f] tells whether f lies on
+    // the other side of the boundary than the starting face
+    std::unordered_map<const Face*, bool> parity;
+    vector<CDT::Face_handle> visited;
+    std::queue<CDT::Face_handle> queue;
+
+    int status = -1;
+
+    parity[&*face] = false;
+    visited.push_back(face);
+    queue.push(face);
+
+    while (!queue.empty() && status < 0) {
+        CDT::Face_handle f = queue.front();
+
+        queue.pop();
+
+        for (int i = 0; i < 3 && status < 0; i++) {
+            CDT::Face_handle neighbor = f->neighbor(i);
+
+            bool p = parity[&*f] != is_boundary_edge(cdt, f, i);
+
+            if (cdt.is_infinite(neighbor) || neighbor->info().in_domain >= 0) {
+                int known = cdt.is_infinite(neighbor) ? 0 : neighbor->info().in_domain;
+
+                status = p ? 1 - known : known;
+            } else if (parity.find(&*neighbor) == parity.end()) {
+                parity[&*neighbor] = p;
+                visited.push_back(neighbor);
+                queue.push(neighbor);
+            }
+        }
+    }
+
+    for (CDT::Face_handle f : visited) {
+        f->info().in_domain = parity[&*f] ? 1 - status : status;
+    }
+
+    return status > 0;
+}
+
+vector<CDT::Face_handle> utils::domain_faces(CDT& cdt) {
+    vector<CDT::Face_handle> faces;
+
+    faces.reserve(cdt.number_of_faces());
+
+    for (auto fit = cdt.finite_faces_begin(); fit != cdt.finite_faces_end(); ++fit) {
+        if (utils::in_domain(cdt, fit)) {
+            faces.push_back(fit);
+        }
+    }
+
+    return faces;
+}
+
+bool utils::edge_in_domain(CDT& cdt, CDT::Face_handle face, int i) {
+    return utils::in_domain(cdt, face) || utils::in_domain(cdt, face->neighbor(i));
+}
+
+void utils::index_vertices(CDT& cdt, VertexHandles& handles) {
+    handles.clear();
+    handles.reserve(cdt.number_of_vertices());
+
+    for (auto vit = cdt.finite_vertices_begin(); vit != cdt.finite_vertices_end(); ++vit) {
+        handles[vit->info().index] = vit;
+    }
+}
+
+bool utils::find_face(CDT& cdt, const VertexHandles& handles, const std::array<unsigned long, 3>& vertices, CDT::Face_handle& face) {
+    Vertex_handle v[3];
+
+    for (int i = 0; i < 3; i++) {
+        auto it = handles.find(vertices[i]);
+
+        if (it == handles.end()) {
+            return false;
+        }
+
+        v[i] = it->second;
+    }
+
+    return cdt.is_face(v[0], v[1], v[2], face);
+}
+
+static void addFaceVertices(CDT& cdt, CDT::Face_handle face, vector<Vertex_handle>& vertices) {
+    for (int i = 0; i < 3; i++) {
+        Vertex_handle v = face->vertex(i);
+
+        if (!cdt.is_infinite(v) && std::find(vertices.begin(), vertices.end(), v) == vertices.end()) {
+            vertices.push_back(v);
+        }
+    }
+}
+
+void utils::candidateFootprint(CDT& cdt, CDT::Face_handle face, const Point* s, int strategy, vector<Vertex_handle>& footprint) {
+    footprint.clear();
+
+    addFaceVertices(cdt, face, footprint);
+
+    for (int i = 0; i < 3; i++) {
+        addFaceVertices(cdt, face->neighbor(i), footprint);
+    }
+
+    if (s == nullptr) {
+        return;
+    }
+
+    CDT::Locate_type lt;
+    int li;
+
+    CDT::Face_handle location = cdt.locate(*s, lt, li, face);
+
+    addFaceVertices(cdt, location, footprint);
+
+    if (lt == CDT::EDGE) {
+        addFaceVertices(cdt, location->neighbor(li), footprint);
+    }
+
+    if (strategy <= 0 && lt != CDT::VERTEX) { // insertByStrategy flips: the whole conflict zone changes
+        std::vector<CDT::Face_handle> conflicts;
+
+        cdt.get_conflicts(*s, std::back_inserter(conflicts), location);
+
+        for (CDT::Face_handle f : conflicts) {
+            addFaceVertices(cdt, f, footprint);
+        }
+    }
+}
+
+static float radius_to_height_ratio(float a, float b, float c) {
+    // Calculate the semi-perimeter of the triangle
+    float s = (a + b + c) / 2.0f;
+
+    // Calculate the area of the triangle using Heron's formula
+    float area = std::sqrt(s * (s - a) * (s - b) * (s - c));
+
+    // Check if the area is zero to prevent division by zero
+    if (area == 0) {
+        std::cerr << "Degenerate triangle detected!" << std::endl;
+        return -1.0f; // Indicate an error
+    }
+
+    // Calculate the circumradius R
+    float R = (a * b * c) / (4.0f * area);
+
+    // Find the longest side
+    float longest_side = std::max({a, b, c});
+
+    // Calculate the height corresponding to the longest side
+    float height = (2.0f * area) / longest_side;
+
+    // Calculate the radius-to-height ratio
+    float rho = R / height;
+
+    return rho;
+}
+
+float utils::radius_to_height_ratio(const Point& p1, const Point& p2, const Point& p3) {
+    // Calculate side lengths of the triangle
+    float a = std::sqrt(CGAL::to_double(CGAL::squared_distance(p2, p3)));
+    float b = std::sqrt(CGAL::to_double(CGAL::squared_distance(p1, p3)));
+    float c = std::sqrt(CGAL::to_double(CGAL::squared_distance(p1, p2)));
+
+    return ::radius_to_height_ratio(a, b, c);
+}
+
+float utils::radius_to_height_ratio(CDT::Face_handle face) {
+    const VertexInfo& p1 = utils::approximate(face->vertex(0));
+    const VertexInfo& p2 = utils::approximate(face->vertex(1));
+    const VertexInfo& p3 = utils::approximate(face->vertex(2));
+
+    float a = std::hypot(p2.x - p3.x, p2.y - p3.y);
+    float b = std::hypot(p1.x - p3.x, p1.y - p3.y);
+    float c = std::hypot(p1.x - p2.x, p1.y - p2.y);
+
+    return ::radius_to_height_ratio(a, b, c);
+}
+
+const VertexInfo& utils::approximate(Vertex_handle v) {
+    VertexInfo& info = v->info();
+
+    if (!info.approximated) {
+        std::pair<double, double> x = CGAL::to_interval(v->point().x());
+        std::pair<double, double> y = CGAL::to_interval(v->point().y());
+
+        info.x = CGAL::to_double(v->point().x());
+        info.y = CGAL::to_double(v->point().y());
+        info.err = std::max(x.second - x.first, y.second - y.first);
+        info.approximated = true;
+    }
+
+    return info;
+}
+
+void utils::approximate(CDT& cdt) {
+    for (auto vit = cdt.finite_vertices_begin(); vit != cdt.finite_vertices_end(); ++vit) {
+        utils::approximate(vit);
+    }
+}
+
+void utils::spatial_order(vector<CDT::Face_handle>& faces) {
+    typedef CGAL::Exact_predicates_inexact_constructions_kernel Epick;
+    typedef CGAL::Spatial_sort_traits_adapter_2<Epick, CGAL::Pointer_property_map<Epick::Point_2>::const_type> Traits;
+
+    vector<Epick::Point_2> centroids;
+
+    centroids.reserve(faces.size());
+
+    for (CDT::Face_handle face : faces) {
+        const VertexInfo& a = utils::approximate(face->vertex(0));
+        const VertexInfo& b = utils::approximate(face->vertex(1));
+        const VertexInfo& c = utils::approximate(face->vertex(2));
+
+        centroids.emplace_back((a.x + b.x + c.x) / 3, (a.y + b.y + c.y) / 3);
+    }
+
+    vector<std::ptrdiff_t> order(faces.size());
+
+    std::iota(order.begin(), order.end(), 0);
+
+    CGAL::hilbert_sort(order.begin(), order.end(), Traits(CGAL::make_property_map(centroids)));
+
+    vector<CDT::Face_handle> sorted;
+
+    sorted.reserve(faces.size());
+
+    for (std::ptrdiff_t i : order) {
+        sorted.push_back(faces[i]);
+    }
+
+    faces.swap(sorted);
+}
+
+void utils::traversal_order(vector<CDT::Face_handle>& faces) {
+    if (SPATIAL_FACE_ORDER) {
+        utils::spatial_order(faces);
+    }
+}
+
+bool utils::has_cached_obtuse_angle(CDT::Face_handle face) {
+    const FaceInfo& info = face->info();
+
+    if (info.dirty) {
+        return false;
+    }
+
+    for (int k = 0; k < 3; k++) {
+        if (info.vertices[k] != face->vertex(k)->info().index) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void utils::cache_obtuse_angle(CDT::Face_handle face, int obtuse_vertex) {
+    FaceInfo& info = face->info();
+
+    for (int k = 0; k < 3; k++) {
+        info.vertices[k] = face->vertex(k)->info().index;
+    }
+
+    info.obtuse = obtuse_vertex >= 0;
+    info.obtuse_vertex = (signed char)obtuse_vertex;
+    info.dirty = false;
+}
+
+int utils::find_obtuse_angle(CDT::Face_handle face) {
+    if (!utils::has_cached_obtuse_angle(face)) {
+        Point a = face->vertex(0)->point();
+        Point b = face->vertex(1)->point();
+        Point c = face->vertex(2)->point();
+
+        utils::cache_obtuse_angle(face, utils::find_obtuse_angle(a, b, c));
+    }
+
+    return face->info().obtuse_vertex;
+}
+
+bool utils::is_obtuse(CDT::Face_handle face) {
+    return utils::find_obtuse_angle(face) >= 0;
+}
+
+double utils::obtuse_severity(CDT& cdt, CDT::Face_handle face) {
+    int i = utils::find_obtuse_angle(face);
+
+    if (i < 0) {
+        return 0;
+    }
+
+    std::tuple<int, int> edge_indices = utils::findOppositeEdge(i);
+
+    const VertexInfo& p = utils::approximate(face->vertex(i));
+    const VertexInfo& q = utils::approximate(face->vertex(std::get<0>(edge_indices)));
+    const VertexInfo& r = utils::approximate(face->vertex(std::get<1>(edge_indices)));
+
+    double ux = q.x - p.x;
+    double uy = q.y - p.y;
+    double vx = r.x - p.x;
+    double vy = r.y - p.y;
+
+    double length = std::sqrt((ux * ux + uy * uy) * (vx * vx + vy * vy));
+    double cosine = (length > 0) ? (ux * vx + uy * vy) / length : -1.0; // in [-1, 0) for an obtuse angle
+
+    float rho = utils::radius_to_height_ratio(face);
+
+    int obtuse_neighbors = 0;
+
+    for (int n = 0; n < 3; n++) {
+        CDT::Face_handle neighbor = face->neighbor(n);
+
+        if (!utils::in_domain(cdt, neighbor)) {
+            continue;
+        }
+
+        if (utils::is_obtuse(neighbor)) {
+            obtuse_neighbors++;
+        }
+    }
+
+    double severity = 1.0 + std::max(-cosine, 0.0) + 0.1 * std::min(std::max(rho, 0.0f), 10.0f) + 0.25 * obtuse_neighbors;
+
+    if (face->is_constrained(i)) { // PERICENTER is ruled out and the angle cannot be split across the edge
+        severity *= 0.5;
+    }
+
+    return severity;
+}
+
+static int countObtuseFace(CDT& cdt, CDT::Face_handle face) {
+    if (!utils::in_domain(cdt, face)) {
+        return 0;
+    }
+
+    return utils::is_obtuse(face) ? 1 : 0;
+}
+
+int utils::obtuseReductionBound(CDT& cdt, CDT::Face_handle face, const Point* s, int strategy, const Polygon_2& boundaryPolygon) {
+    if (strategy <= 0 || s == nullptr) {
+        return std::numeric_limits<int>::max();
+    }
+
+    if (!utils::is_steiner_point_valid(boundaryPolygon, *s, cdt.domain_index)) { // the point will not be inserted
+        return 0;
+    }
+
+    CDT::Locate_type lt;
+    int li;
+
+    CDT::Face_handle location = cdt.locate(*s, lt, li, face);
+
+    if (lt == CDT::FACE) {
+        return countObtuseFace(cdt, location);
+    }
+
+    if (lt == CDT::EDGE) {
+        return countObtuseFace(cdt, location) + countObtuseFace(cdt, location->neighbor(li));
+    }
+
+    return 0; // existing vertex or outside the convex hull: no finite face is destroyed
 }
\ No newline at end of file
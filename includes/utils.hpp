@@ -1,10 +1,13 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <array>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
+#include "BoundaryIndex.h"
 #include "cgal_definitions.h"
 #include "graph_definitions.h"
 
@@ -20,6 +23,9 @@ namespace utils {
 
     string coordinate_to_rational(const K::FT& coord);    
 
+    // Bits in the numerator and denominator of the exact coordinate
+    size_t coordinate_bits(const K::FT& coord);
+
     std::tuple<int, int> findOppositeEdge(int vertexIndex);
 
     bool checkConstraints(const CDT& cdt, const Polygon_2& boundaryPolygon, const Point& p1, const Point& p2);
@@ -32,15 +38,22 @@ namespace utils {
 
     int countObtuseTriangles(CDT& cdt, const Polygon_2& boundaryPolygon);
 
+    // polygon.bounded_side(point), through index when it is the index of polygon
+    // (CDT::domain_index for the domain boundary); other polygons are scanned
+    CGAL::Bounded_side bounded_side(const Polygon_2& polygon, const Point& point, const BoundaryIndex* index = nullptr);
+
     bool is_point_inside_polygon(const Polygon_2& polygon, const Point& point);
 
-    bool is_steiner_point_valid(const Polygon_2& polygon, const Point& point);
+    bool is_steiner_point_valid(const Polygon_2& polygon, const Point& point, const BoundaryIndex* index = nullptr);
 
     // index 0: vertex a: edge: bc
     // index 1: vertex b: edge: ac
     // index 2: vertex c: edge: ab
     Face * findNeighbor(Graph & graph, Point& a, Point& b, Point& c, int vertex_index, int & neighbor_vertex_index);
 
+    // Same, for the edge of face opposite to vertex_index; does not locate
+    Face * findNeighbor(CDT& cdt, const Polygon_2& boundaryPolygon, CDT::Face_handle face, int vertex_index, int & neighbor_vertex_index);
+
 
     bool is_convex(const std::vector<Point>& boundary);
 
@@ -48,11 +61,83 @@ namespace utils {
 
     double calculate_p(int steiner_points, int step, int obtuse_triangles_before, int obtuse_triangles_after);
 
-    bool edge_inside_boundary(const Polygon_2& boundaryPolygon, Point & p1, Point & p2);
+    bool edge_inside_boundary(const Polygon_2& boundaryPolygon, Point & p1, Point & p2, const BoundaryIndex* index = nullptr);
     
-    bool edge_inside_boundary(const Polygon_2& boundaryPolygon, Vertex_handle v1, Vertex_handle v2);
+    bool edge_inside_boundary(const Polygon_2& boundaryPolygon, Vertex_handle v1, Vertex_handle v2, const BoundaryIndex* index = nullptr);
 
     bool face_inside_boundary(const Polygon_2& boundaryPolygon, CDT::Face_handle& face);
+
+    // Builds the instance triangulation: the points in one spatially sorted range insertion
+    // (VertexInfo::input keeps each point's index), then the constraints and the closed
+    // region boundary, given by point indices, between the inserted vertices
+    void buildTriangulation(CDT& cdt, const vector<Point>& points, const vector<std::pair<int, int>>& constraints, const vector<int>& boundary);
+
+    // Flags every face inside or outside boundaryPolygon with a flood fill from the
+    // infinite face that toggles across the constrained edges lying on the boundary.
+    // index, the BoundaryIndex of boundaryPolygon, is kept next to it in cdt.domain_index
+    void markDomain(CDT& cdt, const Polygon_2& boundaryPolygon, const BoundaryIndex* index = nullptr);
+
+    // Whether face is inside the domain; faces created since markDomain are resolved
+    // here from their flagged neighbours. Not thread safe for unresolved faces.
+    bool in_domain(CDT& cdt, CDT::Face_handle face);
+
+    // The finite faces inside the domain, all resolved
+    vector<CDT::Face_handle> domain_faces(CDT& cdt);
+
+    // An edge is exported and counted when it bounds a face of the domain
+    bool edge_in_domain(CDT& cdt, CDT::Face_handle face, int i);
+
+    // Vertex handles by VertexInfo::index. Copies of a triangulation share the indices,
+    // so structures keyed by index survive swapping an evaluated copy into place.
+    typedef std::unordered_map<unsigned long, Vertex_handle> VertexHandles;
+
+    void index_vertices(CDT& cdt, VertexHandles& handles);
+
+    // The face spanned by the vertices with these indices, if it still exists
+    bool find_face(CDT& cdt, const VertexHandles& handles, const std::array<unsigned long, 3>& vertices, CDT::Face_handle& face);
+
+    // Radius of the circumcircle over the height on the longest edge (computed in doubles)
+    float radius_to_height_ratio(const Point& p1, const Point& p2, const Point& p3);
+
+    // Same, from the cached vertex approximations (see approximate)
+    float radius_to_height_ratio(CDT::Face_handle face);
+
+    // Fills the double approximation of a vertex once; not thread safe
+    const VertexInfo& approximate(Vertex_handle v);
+
+    // Approximates every vertex, so that readers may run in parallel
+    void approximate(CDT& cdt);
+
+    // Reorders faces along a Hilbert curve over their (approximate) centroids, so that
+    // consecutive faces are close in the plane; not thread safe (see approximate)
+    void spatial_order(vector<CDT::Face_handle>& faces);
+
+    // spatial_order when SPATIAL_FACE_ORDER is enabled, otherwise leaves faces as they are
+    void traversal_order(vector<CDT::Face_handle>& faces);
+
+    // Cached find_obtuse_angle / is_obtuse of a face, recomputed when the face
+    // is dirty or its vertices changed since it was cached
+    int find_obtuse_angle(CDT::Face_handle face);
+
+    bool is_obtuse(CDT::Face_handle face);
+
+    bool has_cached_obtuse_angle(CDT::Face_handle face);
+
+    void cache_obtuse_angle(CDT::Face_handle face, int obtuse_vertex);
+
+    // Priority of an obtuse face: wider angles, worse shape and obtuse neighbors rank
+    // higher, an obtuse angle facing a constrained edge ranks lower. Positive for obtuse
+    // faces, 0 otherwise.
+    double obtuse_severity(CDT& cdt, CDT::Face_handle face);
+
+    // Upper bound on the obtuse triangles removed by inserting s: only the faces the
+    // insertion destroys can stop being obtuse. Unbounded (INT_MAX) for strategies
+    // that flip or edit constraints (strategy <= 0).
+    int obtuseReductionBound(CDT& cdt, CDT::Face_handle face, const Point* s, int strategy, const Polygon_2& boundaryPolygon);
+
+    // Vertices of the faces that inserting s (generated from face) would modify,
+    // plus the face and its neighbors. With s == nullptr only the latter are returned.
+    void candidateFootprint(CDT& cdt, CDT::Face_handle face, const Point* s, int strategy, vector<Vertex_handle>& footprint);
 }
 
 string to_rational(const K::FT& coord);
@@ -1,8 +1,11 @@
 // Standard C++
+#include <algorithm>
+#include <chrono>
 #include <gmp.h>
 #include <iostream>
 #include <map>
 #include <time.h>
+#include <unordered_map>
 #include <vector>
 
 // Macros and headers for CGAL
@@ -18,16 +21,23 @@
 #include "triangulation_configuration.h"
 
 // Support classes
+#include "BoundaryIndex.h"
 #include "JsonExporter.h"
 #include "JsonLoader.h"
 #include "graph_definitions.h"
+#include "search_traits.h"
 #include "steiner_strategies.h"
 #include "utils.hpp"
 
 #include "AntColonySearch.h"
+#include "EdgeFlipSearch.h"
 #include "LocalSearch.h"
+#include "OrthogonalMeshing.h"
+#include "ParallelLocalSearch.h"
+#include "QuadtreeMeshing.h"
 #include "SimpleTriangulationSearch.h"
 #include "SimulatedAnnealingSearch.h"
+#include "TaskScheduler.h"
 
 // Namespaces
 using namespace std;
@@ -135,6 +145,34 @@ int main(int argc, char* argv[]) {
             loader.method = "acls";
         }
 
+        if (strcmp(argv[i], "-m") == 0 && strcmp(argv[i + 1], "pls") == 0) {
+            loader.method = "parallel";
+        }
+
+        if (strcmp(argv[i], "-m") == 0 && strcmp(argv[i + 1], "flip") == 0) {
+            loader.method = "flip";
+        }
+
+        if (strcmp(argv[i], "-m") == 0 && strcmp(argv[i + 1], "quadtree") == 0) {
+            loader.method = "quadtree";
+        }
+
+        if (strcmp(argv[i], "-m") == 0 && strcmp(argv[i + 1], "qtls") == 0) {
+            loader.method = "qtls";
+        }
+
+        if (strcmp(argv[i], "-m") == 0 && strcmp(argv[i + 1], "ortho") == 0) {
+            loader.method = "ortho";
+        }
+
+        if (strcmp(argv[i], "-m") == 0 && strcmp(argv[i + 1], "ortholls") == 0) {
+            loader.method = "ortholls";
+        }
+
+        if (strcmp(argv[i], "-O") == 0 && strcmp(argv[i + 1], "true") == 0) {
+            loader.orthogonal_start = true;
+        }
+
 
         if (strcmp(argv[i], "-m") == 0 && strcmp(argv[i + 1], "legacy") == 0) {
             loader.method = "legacy";
@@ -144,6 +182,18 @@ int main(int argc, char* argv[]) {
             loader.randomize_on_deadend = true;
         }
 
+        if (strcmp(argv[i], "-S") == 0) {
+            loader.strategy_selection = argv[i + 1];
+        }
+
+        if (strcmp(argv[i], "-F") == 0) {
+            loader.flip_pass = argv[i + 1];
+        }
+
+        if (strcmp(argv[i], "-D") == 0) {
+            steiner_stategies::setRoundingDenominator(atol(argv[i + 1]));
+        }
+
         load_parameters = false;
     }
 
@@ -158,33 +208,17 @@ int main(int argc, char* argv[]) {
     CDT cdt;
 
     //
-    // Add vertices to graph
+    // Add vertices, edges and boundaries to graph
     //
     vector<Point> points = loader.getPoints();
-
-    for (const Point& p : points) {
-        cdt.insert(p);
-    }
-
-    //
-    // Add edges to graph
-    //
     std::vector<std::pair<int, int>> constraints = loader.getConstraints();
-
-    for (const auto& constraint : constraints) {
-        cdt.insert_constraint(points[constraint.first], points[constraint.second]);
-    }
-
-    //
-    // Add boundaries as edges to graph
-    //
     std::vector<int> boundary_constraints = loader.getRegionBoundaries();
 
-    for (size_t i = 0, j = 1; i < boundary_constraints.size() && j < boundary_constraints.size(); i++, j++) {
-        cdt.insert_constraint(points[boundary_constraints[i]], points[boundary_constraints[j]]);
-    }
+    auto build_start = std::chrono::steady_clock::now();
 
-    cdt.insert_constraint(points[boundary_constraints[boundary_constraints.size() - 1]], points[boundary_constraints[0]]);
+    utils::buildTriangulation(cdt, points, constraints, boundary_constraints);
+
+    cout << "Triangulation built in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count() << " ms (" << cdt.number_of_vertices() << " vertices)" << endl;
 
     //
     // Create a polygon for the boundary
@@ -195,6 +229,10 @@ int main(int argc, char* argv[]) {
         boundaryPolygon.push_back(points[boundary_constraints[i]]);
     }
 
+    BoundaryIndex boundaryIndex(boundaryPolygon); // boundary tests no longer scan the whole polygon
+
+    utils::markDomain(cdt, boundaryPolygon, &boundaryIndex); // faces outside the boundary are neither counted nor refined
+
     if (DRAW) {
         // CGAL::draw(cdt);
     }
@@ -209,13 +247,75 @@ int main(int argc, char* argv[]) {
 
     vector<Point> steinerPoints;
 
-    if (loader.getMethod() == "legacy") {
-        SimpleTriangulationSearch<float> triangulator;
+    EdgeFlipSearch<SearchTraits> flipper;
+
+    if ((loader.getMethod() == "ortho" || loader.getMethod() == "ortholls") && !loader.isOrthogonal()) {
+        cerr << "The instance boundary is not orthogonal \n";
+        return -1;
+    }
+
+    // On orthogonal instances the engines can start from the right-angle grid
+    vector<Point> startPoints;
+
+    if (loader.isOrthogonal() && (loader.orthogonal_start || loader.getMethod() == "ortholls") && loader.getMethod() != "ortho") { // -m ortho is the grid itself
+        OrthogonalMeshing<SearchTraits> mesher;
+
+        startPoints = mesher.triangulate(graph, loader);
+    }
+
+    if (loader.flip_pass == "pre" || loader.flip_pass == "both") {
+        cout << "Flip pre-pass: " << flipper.improve(graph) << " flips" << endl;
+    }
+
+    if (loader.getMethod() == "flip") {
+        steinerPoints = flipper.triangulate(graph);
+    } else if (loader.getMethod() == "ortho") {
+        OrthogonalMeshing<SearchTraits> mesher;
+
+        steinerPoints = mesher.triangulate(graph, loader);
+    } else if (loader.getMethod() == "quadtree") {
+        QuadtreeMeshing<SearchTraits> mesher;
+
+        steinerPoints = mesher.triangulate(graph, loader, boundaryPolygon);
+    } else if (loader.getMethod() == "qtls") {
+        QuadtreeMeshing<SearchTraits> mesher;
+
+        steinerPoints = mesher.triangulate(graph, loader, boundaryPolygon);
+
+        LocalSearch<SearchTraits> triangulator_ls;
+
+        vector<steiner_stategies::Strategy> strategies;
+
+        strategies.push_back(steiner_stategies::Strategy::MAX_EDGE);
+        strategies.push_back(steiner_stategies::Strategy::PERICENTER);
+        strategies.push_back(steiner_stategies::Strategy::POLYGON);
+        strategies.push_back(steiner_stategies::Strategy::PROJECTION);
+        strategies.push_back(steiner_stategies::Strategy::CENTROID);
+
+        vector<Point> steinerPoints2 = triangulator_ls.triangulate(strategies, graph, loader, boundaryPolygon);
+
+        for (Point& p : steinerPoints2) {
+            steinerPoints.emplace_back(p);
+        }
+    } else if (loader.getMethod() == "legacy") {
+        SimpleTriangulationSearch<SearchTraits> triangulator;
 
         steiner_stategies::Strategy strategy = steiner_stategies::Strategy::PROJECTION;
         steinerPoints = triangulator.triangulate(strategy, graph, loader, boundaryPolygon);
     } else if (loader.getMethod() == "local") {
-        LocalSearch<float> triangulator;
+        LocalSearch<SearchTraits> triangulator;
+
+        vector<steiner_stategies::Strategy> strategies;
+
+        strategies.push_back(steiner_stategies::Strategy::MAX_EDGE);
+        strategies.push_back(steiner_stategies::Strategy::PERICENTER);
+        strategies.push_back(steiner_stategies::Strategy::POLYGON);
+        strategies.push_back(steiner_stategies::Strategy::PROJECTION);
+        strategies.push_back(steiner_stategies::Strategy::CENTROID);
+
+        steinerPoints = triangulator.triangulate(strategies, graph, loader, boundaryPolygon);
+    } else if (loader.getMethod() == "parallel") {
+        ParallelLocalSearch<SearchTraits> triangulator;
 
         vector<steiner_stategies::Strategy> strategies;
 
@@ -227,7 +327,7 @@ int main(int argc, char* argv[]) {
 
         steinerPoints = triangulator.triangulate(strategies, graph, loader, boundaryPolygon);
     } else if (loader.getMethod() == "sa") {
-        SimulatedAnnealingSearch<float> triangulator;
+        SimulatedAnnealingSearch<SearchTraits> triangulator;
 
         vector<steiner_stategies::Strategy> strategies;
 
@@ -245,7 +345,7 @@ int main(int argc, char* argv[]) {
 
         steinerPoints = triangulator.triangulate(strategies, graph, loader, boundaryPolygon, alpha, beta);
     } else if (loader.getMethod() == "ant") {
-        AntColonySearch<float> triangulator;
+        AntColonySearch<SearchTraits> triangulator;
 
         vector<steiner_stategies::Strategy> strategies;
 
@@ -263,7 +363,7 @@ int main(int argc, char* argv[]) {
 
         steinerPoints = triangulator.triangulate(strategies, graph, loader, boundaryPolygon, alpha, beta);
     } else if (loader.getMethod() == "sals") {
-        SimulatedAnnealingSearch<float> triangulator;
+        SimulatedAnnealingSearch<SearchTraits> triangulator;
 
         vector<steiner_stategies::Strategy> strategies;
 
@@ -281,7 +381,7 @@ int main(int argc, char* argv[]) {
 
         steinerPoints = triangulator.triangulate(strategies, graph, loader, boundaryPolygon, alpha, beta);
 
-        LocalSearch<float> triangulator_ls;
+        LocalSearch<SearchTraits> triangulator_ls;
 
         vector<Point> steinerPoints2 = triangulator_ls.triangulate(strategies, graph, loader, boundaryPolygon);
 
@@ -289,7 +389,7 @@ int main(int argc, char* argv[]) {
             steinerPoints.emplace_back(p);
         }
     } else if (loader.getMethod() == "acls") {
-        AntColonySearch<float> triangulator;
+        AntColonySearch<SearchTraits> triangulator;
 
         vector<steiner_stategies::Strategy> strategies;
 
@@ -307,18 +407,41 @@ int main(int argc, char* argv[]) {
 
         steinerPoints = triangulator.triangulate(strategies, graph, loader, boundaryPolygon, alpha, beta);
 
-        LocalSearch<float> triangulator_ls;
+        LocalSearch<SearchTraits> triangulator_ls;
 
         vector<Point> steinerPoints2 = triangulator_ls.triangulate(strategies, graph, loader, boundaryPolygon);
 
         for (Point& p : steinerPoints2) {
             steinerPoints.emplace_back(p);
         }
+    } else if (loader.getMethod() == "ortholls") {
+        LocalSearch<SearchTraits> triangulator_ls;
+
+        vector<steiner_stategies::Strategy> strategies;
+
+        strategies.push_back(steiner_stategies::Strategy::MAX_EDGE);
+        strategies.push_back(steiner_stategies::Strategy::PERICENTER);
+        strategies.push_back(steiner_stategies::Strategy::POLYGON);
+        strategies.push_back(steiner_stategies::Strategy::PROJECTION);
+        strategies.push_back(steiner_stategies::Strategy::CENTROID);
+
+        steinerPoints = triangulator_ls.triangulate(strategies, graph, loader, boundaryPolygon);
     } else {
         cerr << "Unknown method of search \n";
         return -1;
     }
 
+    steinerPoints.insert(steinerPoints.begin(), startPoints.begin(), startPoints.end());
+
+    if (loader.flip_pass == "post" || loader.flip_pass == "both") {
+        cout << "Flip post-pass: " << flipper.improve(graph) << " flips, obtuse triangles: " << SearchTraits::countObtuseTriangles(cdt, boundaryPolygon) << endl;
+    }
+
+    cout << "Boundary queries: " << boundaryIndex.fast_queries() << " indexed, " << boundaryIndex.fallback_queries() << " by bounded_side" << endl;
+
+    steiner_stategies::printRounding();
+    TaskScheduler::instance().print();
+
     //
     // Export
     //
@@ -330,19 +453,45 @@ int main(int argc, char* argv[]) {
         exporter.steiner_points_y.emplace_back(s2);
     }
 
-    std::vector<Vertex_handle> vertices;
+    // Export indices: input vertices by their input index (the build inserts them
+    // spatially sorted), Steiner vertices after them in the order written above
+    const int input_points = points.size();
+
+    std::map<Point, int, K::Less_xy_2> steiner_indices;
+
+    for (size_t i = 0; i < steinerPoints.size(); i++) {
+        steiner_indices.emplace(steinerPoints[i], input_points + (int)i); // the first of repeated points
+    }
+
+    std::unordered_map<Vertex_handle, int> vertices; // vertex handle -> export index
 
     for (auto vit = cdt.finite_vertices_begin(); vit != cdt.finite_vertices_end(); ++vit) {
-        vertices.push_back(vit); // Store the vertex handle
+        if (vit->info().input >= 0) {
+            vertices[vit] = vit->info().input;
+            continue;
+        }
+
+        auto it = steiner_indices.find(vit->point());
+
+        if (it == steiner_indices.end()) { // not reported by the engine: exported after the others
+            cerr << "Steiner vertex missing from the solution: " << vit->point() << endl;
+
+            it = steiner_indices.emplace(vit->point(), input_points + (int)exporter.steiner_points_x.size()).first;
+
+            exporter.steiner_points_x.emplace_back(to_rational(vit->point().x()));
+            exporter.steiner_points_y.emplace_back(to_rational(vit->point().y()));
+        }
+
+        vertices[vit] = it->second;
     }
 
     for (auto edge = cdt.finite_edges_begin(); edge != cdt.finite_edges_end(); ++edge) {
         Vertex_handle v1 = edge->first->vertex(cdt.cw(edge->second));
         Vertex_handle v2 = edge->first->vertex(cdt.ccw(edge->second));
 
-        if (utils::edge_inside_boundary(boundaryPolygon, v1, v2)) {
-            int x1 = std::find(vertices.begin(), vertices.end(), v1) - vertices.begin(); // Index of vertex 1
-            int x2 = std::find(vertices.begin(), vertices.end(), v2) - vertices.begin(); // Index of vertex 2
+        if (utils::edge_in_domain(cdt, edge->first, edge->second)) {
+            int x1 = vertices[v1]; // Index of vertex 1
+            int x2 = vertices[v2]; // Index of vertex 2
 
             exporter.edges.emplace_back(x1, x2);
         }
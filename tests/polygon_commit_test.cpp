@@ -0,0 +1,96 @@
+//
+// A POLYGON commit constrains the region convexRegion merges around the face
+// and inserts its point; the points strictly inside that region are then
+// removed. The region has to be computed before the insertion, which
+// destroys the face.
+//
+// The face a, b, c is obtuse at c and its neighbour across c, a is obtuse at
+// a; together they form the convex quadrilateral a, b, c, n, whose centroid
+// is the POLYGON point. After the commit no vertex may lie strictly inside
+// the quadrilateral and its four sides must be constrained.
+//
+
+#include <iostream>
+#include <vector>
+
+#include "cgal_definitions.h"
+#include "graph_definitions.h"
+#include "steiner_strategies.h"
+#include "utils.hpp"
+
+using namespace std;
+
+static bool findVertex(CDT& cdt, const Point& p, Vertex_handle& v) {
+    CDT::Locate_type lt;
+    int li;
+
+    CDT::Face_handle face = cdt.locate(p, lt, li);
+
+    if (lt != CDT::VERTEX) {
+        return false;
+    }
+
+    v = face->vertex(li);
+
+    return true;
+}
+
+int main() {
+    Point a(0, 0), b(10, 0), c(5, 1), n(-1, 1);
+
+    vector<Point> corners = {a, b, c, n};
+
+    CDT cdt;
+
+    for (const Point& p : corners) {
+        cdt.insert(p);
+    }
+
+    Polygon boundaryPolygon(corners.begin(), corners.end());
+
+    Graph graph;
+    graph.cdt = &cdt;
+    graph.boundaryPolygon = &boundaryPolygon;
+
+    int failures = 0;
+
+    vector<Point> region = steiner_stategies::convexRegion(graph, a, b, c);
+
+    if (region.size() != 4) {
+        cout << "FAIL: region of " << region.size() << " points, expected 4" << endl;
+        failures++;
+    }
+
+    Point s = utils::centroid(corners);
+
+    steiner_stategies::applySteinerPoint(graph, a, b, c, s, steiner_stategies::Strategy::POLYGON);
+
+    for (auto vit = cdt.finite_vertices_begin(); vit != cdt.finite_vertices_end(); ++vit) {
+        if (boundaryPolygon.bounded_side(vit->point()) == CGAL::ON_BOUNDED_SIDE) {
+            cout << "FAIL: vertex " << vit->point() << " left inside the region" << endl;
+            failures++;
+        }
+    }
+
+    for (size_t i = 0; i < corners.size(); i++) {
+        Vertex_handle u, v;
+
+        if (!findVertex(cdt, corners[i], u) || !findVertex(cdt, corners[(i + 1) % corners.size()], v)) {
+            cout << "FAIL: region corner removed" << endl;
+            failures++;
+            continue;
+        }
+
+        CDT::Face_handle face;
+        int index;
+
+        if (!cdt.is_edge(u, v, face, index) || !cdt.is_constrained(CDT::Edge(face, index))) {
+            cout << "FAIL: side " << corners[i] << " - " << corners[(i + 1) % corners.size()] << " not constrained" << endl;
+            failures++;
+        }
+    }
+
+    cout << (failures == 0 ? "PASS" : "FAIL") << ": POLYGON commit, " << cdt.number_of_vertices() << " vertices" << endl;
+
+    return failures == 0 ? 0 : 1;
+}